@@ -0,0 +1,103 @@
+// chess-bench: escalado de la búsqueda con Lazy SMP.
+// Para 1..N hilos busca cada posición a profundidad fija con la TT limpia y
+// mide el tiempo hasta esa profundidad (time-to-depth) y la aceleración.
+//
+// Uso: chess-bench [--threads N] [--depth D] [--hash MB] [--huge] [--json]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "board.h"
+#include "perft.h"
+#include "search.h"
+#include "clock.h"
+
+// Posiciones de medio juego variadas (las de la suite de perft)
+static const char *POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+};
+#define NUM_POSITIONS ((int)(sizeof(POSITIONS) / sizeof(POSITIONS[0])))
+
+typedef struct {
+    int maxThreads;
+    int depth;
+    int hashMB;
+    int huge;
+    int json;
+} Options;
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Uso: %s [--threads N] [--depth D] [--hash MB] [--huge] [--json]\n"
+            "  --threads N  hasta N hilos (por defecto, todos los núcleos)\n"
+            "  --depth D    profundidad fija por posición (por defecto 8)\n"
+            "  --hash MB    tamaño de la TT (por defecto 64)\n"
+            "  --huge       intentar páginas enormes para la TT\n"
+            "  --json       una línea JSON por cantidad de hilos\n",
+            argv0);
+}
+
+static int parse_args(int argc, char **argv, Options *o) {
+    *o = (Options){ 0, 8, 64, 0, 0 };
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        int hasVal = (i + 1 < argc);
+        if      (!strcmp(a, "--threads") && hasVal) o->maxThreads = atoi(argv[++i]);
+        else if (!strcmp(a, "--depth")   && hasVal) o->depth      = atoi(argv[++i]);
+        else if (!strcmp(a, "--hash")    && hasVal) o->hashMB     = atoi(argv[++i]);
+        else if (!strcmp(a, "--huge"))   o->huge = 1;
+        else if (!strcmp(a, "--json"))   o->json = 1;
+        else { usage(argv[0]); return 0; }
+    }
+    return o->depth > 0 && o->hashMB > 0;
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!parse_args(argc, argv, &o)) return 2;
+    if (o.maxThreads <= 0) o.maxThreads = perft_default_threads();
+
+    TransTable tt;
+    if (!tt_init(&tt, (size_t)o.hashMB, o.huge)) { fprintf(stderr, "Sin memoria para la TT\n"); return 2; }
+    if (!o.json) {
+        printf("Lazy SMP: %d posiciones, profundidad %d, TT %d MB%s\n",
+               NUM_POSITIONS, o.depth, o.hashMB, tt.mapped ? " (páginas enormes)" : "");
+        printf("%7s %10s %9s %14s %10s\n", "hilos", "tiempo", "acel.", "nodos", "Mnps");
+    }
+
+    double baseTime = 0.0;
+    for (int threads = 1; threads <= o.maxThreads; ++threads) {
+        double total = 0.0;
+        uint64_t nodes = 0;
+        for (int i = 0; i < NUM_POSITIONS; ++i) {
+            Position pos;
+            if (!position_from_fen(&pos, POSITIONS[i])) return 2;
+            tt_clear(&tt);
+            SearchLimits lim = { 0 };
+            lim.maxDepth = o.depth;
+            lim.tt = &tt;
+            lim.threads = threads;
+            SearchInfo info;
+            double t0 = clock_now();
+            search_best_move(&pos, &lim, &info);
+            total += clock_now() - t0;
+            nodes += info.nodes;
+        }
+        if (threads == 1) baseTime = total;
+        double speedup = total > 0.0 ? baseTime / total : 0.0;
+        double mnps = total > 0.0 ? (double)nodes / total / 1e6 : 0.0;
+
+        if (o.json)
+            printf("{\"threads\":%d,\"depth\":%d,\"seconds\":%.6f,\"speedup\":%.3f,\"nodes\":%llu,\"nps\":%.0f}\n",
+                   threads, o.depth, total, speedup, (unsigned long long)nodes, mnps * 1e6);
+        else
+            printf("%7d %9.3fs %8.2fx %14llu %10.2f\n", threads, total, speedup, (unsigned long long)nodes, mnps);
+        fflush(stdout);
+    }
+
+    tt_free(&tt);
+    return 0;
+}
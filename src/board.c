@@ -1,52 +1,38 @@
 #include "board.h"
+#include "stats.h"
 #include <stdio.h>
-
-/* ---------------- Bitboards de piezas ---------------- */
-uint64_t WP, WN, WB, WR, WQ, WK;
-uint64_t BP, BN, BB, BR, BQ, BK;
+#include <stdlib.h>
+#include <string.h>
 
 int square_index(int file, int rank) { return rank * 8 + file; }
 uint64_t bit_at(int sq) { return 1ULL << sq; }
 
-uint64_t occ_white(void) { return WP|WN|WB|WR|WQ|WK; }
-uint64_t occ_black(void) { return BP|BN|BB|BR|BQ|BK; }
-uint64_t occ_all(void)   { return occ_white() | occ_black(); }
-
-static uint64_t* piece_bb[12] = {
-    &WP,&WN,&WB,&WR,&WQ,&WK,
-    &BP,&BN,&BB,&BR,&BQ,&BK
-};
+uint64_t occ_white(const Position *pos) {
+    const uint64_t *b = pos->bb;
+    return b[WP]|b[WN]|b[WB]|b[WR]|b[WQ]|b[WK];
+}
+uint64_t occ_black(const Position *pos) {
+    const uint64_t *b = pos->bb;
+    return b[BP]|b[BN]|b[BB]|b[BR]|b[BQ]|b[BK];
+}
+uint64_t occ_all(const Position *pos) { return occ_white(pos) | occ_black(pos); }
 
 /* ---------------- Consultas ---------------- */
-int piece_code_at(int sq){
-    uint64_t m = bit_at(sq);
-    if (WP&m) return 0; if (WN&m) return 1; if (WB&m) return 2;
-    if (WR&m) return 3; if (WQ&m) return 4; if (WK&m) return 5;
-    if (BP&m) return 6; if (BN&m) return 7; if (BB&m) return 8;
-    if (BR&m) return 9; if (BQ&m) return 10; if (BK&m) return 11;
-    return -1;
-}
-int is_white_at(int sq){ int c = piece_code_at(sq); return (c >= 0 && c <= 5); }
-int is_black_at(int sq){ int c = piece_code_at(sq); return (c >= 6 && c <= 11); }
+int piece_code_at(const Position *pos, int sq){ return pos->mailbox[sq]; }
+int is_white_at(const Position *pos, int sq){ int c = piece_code_at(pos, sq); return (c >= 0 && c <= 5); }
+int is_black_at(const Position *pos, int sq){ int c = piece_code_at(pos, sq); return (c >= 6 && c <= 11); }
 
 /* ---------------- En Passant (estado) ---------------- */
-static int gEpSquare = -1;
-int  get_ep_square(void) { return gEpSquare; }
-void set_ep_square(int sq) { gEpSquare = sq; }
-void clear_ep_square(void) { gEpSquare = -1; }
+int  get_ep_square(const Position *pos) { return pos->ep; }
+void set_ep_square(Position *pos, int sq) { pos->ep = sq; }
+void clear_ep_square(Position *pos) { pos->ep = -1; }
 
 /* ---------------- Derechos de enroque ---------------- */
-static int gCastleRights = 0; // bitmask: 1=WK,2=WQ,4=BK,8=BQ
-int  get_castle_rights(void)     { return gCastleRights; }
-void set_castle_rights(int r)    { gCastleRights = r; }
-void clear_castle_rights(void)   { gCastleRights = 0; }
+int  get_castle_rights(const Position *pos)     { return pos->castle; }
+void set_castle_rights(Position *pos, int r)    { pos->castle = r; }
+void clear_castle_rights(Position *pos)         { pos->castle = 0; }
 
 /* ---------------- Máscaras útiles ---------------- */
-static const uint64_t FILE_A = 0x0101010101010101ULL;
-static const uint64_t FILE_B = 0x0202020202020202ULL;
-static const uint64_t FILE_G = 0x4040404040404040ULL;
-static const uint64_t FILE_H = 0x8080808080808080ULL;
-
 static const uint64_t NOT_FILE_A = 0xfefefefefefefefeULL;
 static const uint64_t NOT_FILE_B = 0xfdfdfdfdfdfdfdfdULL;
 static const uint64_t NOT_FILE_G = 0xbfbfbfbfbfbfbfbfULL;
@@ -55,233 +41,336 @@ static const uint64_t NOT_FILE_H = 0x7f7f7f7f7f7f7f7fULL;
 static const uint64_t RANK_2 = 0x000000000000FF00ULL;
 static const uint64_t RANK_7 = 0x00FF000000000000ULL;
 
+/* ---------------- Variantes por bando ----------------
+ * Las funciones SIDE_FN reciben 'us' (1 = blancas, 0 = negras) como constante
+ * desde un despachador que mira pos->side una sola vez; al inlinearlas el
+ * compilador arma una copia por bando con desplazamientos, filas, casillas de
+ * enroque y bitboards de pieza ya resueltos, sin ramas en el bucle caliente.
+ */
+#define SIDE_FN static inline __attribute__((always_inline))
+
+SIDE_FN uint64_t pawn_push(uint64_t b, int us) { return us ? b << 8 : b >> 8; }
+SIDE_FN uint64_t pawn_attacks(uint64_t p, int us) {
+    return us ? (((p & NOT_FILE_A) << 7) | ((p & NOT_FILE_H) << 9))
+              : (((p & NOT_FILE_H) >> 7) | ((p & NOT_FILE_A) >> 9));
+}
+SIDE_FN uint64_t occ_side(const Position *pos, int us) {
+    const uint64_t *b = pos->bb + (us ? WP : BP);
+    return b[0]|b[1]|b[2]|b[3]|b[4]|b[5];
+}
+
 /* ---------------- Generación: Peones ---------------- */
-static uint64_t gen_pawn_from(int sq, int sideToMove) {
+SIDE_FN uint64_t gen_pawn_side(const Position *pos, int sq, int us) {
     uint64_t m = bit_at(sq);
-    uint64_t empty = ~occ_all();
-    uint64_t moves = 0ULL;
-
-    if (sideToMove == 1) { // blancas
-        uint64_t one = (m << 8) & empty;
-        moves |= one;
-        if ((m & RANK_2) && one) {
-            uint64_t two = (m << 16) & empty & (empty << 8);
-            moves |= two;
-        }
-        uint64_t capL = ((m & ~FILE_A) << 7) & occ_black();
-        uint64_t capR = ((m & ~FILE_H) << 9) & occ_black();
-        moves |= capL | capR;
-
-        if (gEpSquare != -1) {
-            uint64_t epMask = bit_at(gEpSquare);
-            uint64_t epL = ((m & ~FILE_A) << 7) & epMask;
-            uint64_t epR = ((m & ~FILE_H) << 9) & epMask;
-            moves |= epL | epR;
-        }
-    } else { // negras
-        uint64_t one = (m >> 8) & empty;
-        moves |= one;
-        if ((m & RANK_7) && one) {
-            uint64_t two = (m >> 16) & empty & (empty >> 8);
-            moves |= two;
-        }
-        uint64_t capL = ((m & ~FILE_H) >> 7) & occ_white();
-        uint64_t capR = ((m & ~FILE_A) >> 9) & occ_white();
-        moves |= capL | capR;
-
-        if (gEpSquare != -1) {
-            uint64_t epMask = bit_at(gEpSquare);
-            uint64_t epL = ((m & ~FILE_H) >> 7) & epMask;
-            uint64_t epR = ((m & ~FILE_A) >> 9) & epMask;
-            moves |= epL | epR;
-        }
-    }
+    uint64_t empty = ~occ_all(pos);
+    uint64_t one = pawn_push(m, us) & empty;
+    uint64_t moves = one;
+    if (m & (us ? RANK_2 : RANK_7)) moves |= pawn_push(one, us) & empty;
+
+    uint64_t atk = pawn_attacks(m, us);
+    moves |= atk & occ_side(pos, !us);
+    if (pos->ep != -1) moves |= atk & bit_at(pos->ep);
     return moves;
 }
 
-/* ---------------- Ataques precomputados: Caballos y Rey ---------------- */
-static uint64_t KNIGHT_ATTACKS[64];
-static uint64_t KING_ATTACKS[64];
+static uint64_t gen_pawn_from(const Position *pos, int sq, int sideToMove) {
+    return sideToMove ? gen_pawn_side(pos, sq, 1) : gen_pawn_side(pos, sq, 0);
+}
 
-static inline uint64_t shift_north(uint64_t b, int n){ return b << (8*n); }
-static inline uint64_t shift_south(uint64_t b, int n){ return b >> (8*n); }
+/* ---------------- Tablas precomputadas ----------------
+ * Caballo, rey, peones, BETWEEN/LINE, deslizantes y Zobrist los genera
+ * tools/gen_tables.c durante la compilación (board_tables.inc): son
+ * 'static const', viven en páginas de sólo lectura y no hay init al arrancar.
+ *
+ * Deslizantes: para cada casilla, la máscara de casillas relevantes (el rayo
+ * sin el borde final) y una sub-tabla con los ataques de cada ocupación
+ * posible. El índice sale de PEXT si compilamos con BMI2, o de la
+ * multiplicación mágica clásica en otro caso: en ambos casos el ataque es
+ * una sola lectura.
+ *
+ * BETWEEN[a][b]: casillas estrictamente entre a y b si están alineadas.
+ * LINE[a][b]:    la línea completa (borde a borde) que pasa por a y b.
+ */
+#if defined(__BMI2__) && !defined(CHESS_NO_PEXT)
+#include <immintrin.h>
+#define USE_PEXT 1
+#endif
+
+typedef struct {
+    uint64_t        mask;     // casillas relevantes
+    uint64_t        magic;    // multiplicador (sin uso con PEXT)
+    const uint64_t *attacks;  // sub-tabla dentro de BISHOP_TABLE / ROOK_TABLE
+    int             shift;    // 64 - bits relevantes
+} Magic;
+
+#include "board_tables.inc"
+
+static inline unsigned magic_index(const Magic *m, uint64_t occ) {
+#ifdef USE_PEXT
+    return (unsigned)_pext_u64(occ, m->mask);
+#else
+    return (unsigned)(((occ & m->mask) * m->magic) >> m->shift);
+#endif
+}
 
-void board_init_attacks(void) {
-    for (int sq = 0; sq < 64; ++sq) {
-        uint64_t m = bit_at(sq);
-        // Caballo
-        uint64_t atkN = 0ULL;
-        atkN |= shift_north((m & NOT_FILE_H), 2) << 1;
-        atkN |= shift_north((m & NOT_FILE_A), 2) >> 1;
-        atkN |= shift_south((m & NOT_FILE_H), 2) << 1;
-        atkN |= shift_south((m & NOT_FILE_A), 2) >> 1;
-        atkN |= ((m & NOT_FILE_G & NOT_FILE_H) << 2) << 8;
-        atkN |= ((m & NOT_FILE_G & NOT_FILE_H) << 2) >> 8;
-        atkN |= ((m & NOT_FILE_A & NOT_FILE_B) >> 2) << 8;
-        atkN |= ((m & NOT_FILE_A & NOT_FILE_B) >> 2) >> 8;
-        KNIGHT_ATTACKS[sq] = atkN;
-
-        // Rey (8 adyacentes con bordes)
-        uint64_t atkK = 0ULL;
-        uint64_t notA = NOT_FILE_A, notH = NOT_FILE_H;
-        atkK |= (m & notH) << 1;                // E
-        atkK |= (m & notA) >> 1;                // W
-        atkK |= m << 8;                         // N
-        atkK |= m >> 8;                         // S
-        atkK |= (m & notH) << 9;                // NE
-        atkK |= (m & notA) << 7;                // NW
-        atkK |= (m & notH) >> 7;                // SE
-        atkK |= (m & notA) >> 9;                // SW
-        KING_ATTACKS[sq] = atkK;
-    }
-}
-
-/* ---------------- Ataques: Alfiles (raycast en 4 diagonales) ---------------- */
-static uint64_t bishop_attacks_on_the_fly(int sq, uint64_t occ) {
-    uint64_t attacks = 0ULL;
-    int f = sq % 8, r = sq / 8;
-
-    for (int ff=f+1, rr=r+1; ff<8 && rr<8; ++ff, ++rr) { int s=rr*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
-    for (int ff=f-1, rr=r+1; ff>=0 && rr<8; --ff, ++rr) { int s=rr*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
-    for (int ff=f+1, rr=r-1; ff<8 && rr>=0; ++ff, --rr) { int s=rr*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
-    for (int ff=f-1, rr=r-1; ff>=0 && rr>=0; --ff, --rr) { int s=rr*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
-    return attacks;
-}
-
-/* ---------------- Ataques: Torres (raycast ortogonal) ---------------- */
-static uint64_t rook_attacks_on_the_fly(int sq, uint64_t occ) {
-    uint64_t attacks = 0ULL;
-    int f = sq % 8, r = sq / 8;
-
-    for (int rr=r+1; rr<8; ++rr) { int s=rr*8+f; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
-    for (int rr=r-1; rr>=0; --rr){ int s=rr*8+f; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
-    for (int ff=f+1; ff<8; ++ff) { int s=r*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
-    for (int ff=f-1; ff>=0; --ff){ int s=r*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
-    return attacks;
+static inline uint64_t bishop_attacks(int sq, uint64_t occ) {
+    const Magic *m = &BISHOP_MAGICS[sq];
+    STAT_INC(sliderLookups);
+    return m->attacks[magic_index(m, occ)];
+}
+static inline uint64_t rook_attacks(int sq, uint64_t occ) {
+    const Magic *m = &ROOK_MAGICS[sq];
+    STAT_INC(sliderLookups);
+    return m->attacks[magic_index(m, occ)];
+}
+
+uint64_t position_compute_key(const Position *pos) {
+    uint64_t k = 0ULL;
+    for (int sq = 0; sq < 64; ++sq)
+        if (pos->mailbox[sq] >= 0) k ^= ZOBRIST_PIECE[pos->mailbox[sq]][sq];
+    k ^= ZOBRIST_CASTLE[pos->castle];
+    if (pos->ep != -1) k ^= ZOBRIST_EP[pos->ep % 8];
+    if (pos->side == 0) k ^= ZOBRIST_SIDE;
+    return k;
+}
+
+// Las tablas vienen generadas en compilación: no queda nada por preparar.
+// Se mantiene para quien la llame antes de usar el tablero.
+void board_init_attacks(void) {}
+
+/* ---------------- Mapa de ataques de un bando ----------------
+ * Todas las casillas atacadas por 'side' con la ocupación 'occ' (se pasa
+ * aparte para poder "quitar" al rey propio y ver los rayos a través de él).
+ * Rellenos por conjuntos: todos los peones, caballos y deslizantes de un tipo
+ * a la vez, sin recorrer pieza por pieza.
+ */
+static inline uint64_t shift_by(uint64_t b, int s) { return s > 0 ? b << s : b >> -s; }
+
+// Kogge-Stone: los rayos de todos los deslizantes de 'gen' en la dirección 's'
+// (±1, ±7, ±8, ±9) hasta la primera pieza ocupada, incluida.
+// 'wrap' descarta lo que cruza del borde de una columna al otro.
+static inline uint64_t slide_fill(uint64_t gen, uint64_t empty, int s, uint64_t wrap) {
+    uint64_t pro = empty & wrap;
+    gen |= pro & shift_by(gen, s);     pro &= shift_by(pro, s);
+    gen |= pro & shift_by(gen, 2 * s); pro &= shift_by(pro, 2 * s);
+    gen |= pro & shift_by(gen, 4 * s);
+    return shift_by(gen, s) & wrap;
+}
+
+static inline uint64_t knight_fill(uint64_t n) {
+    uint64_t l1 = (n >> 1) & NOT_FILE_H, l2 = (n >> 2) & NOT_FILE_H & NOT_FILE_G;
+    uint64_t r1 = (n << 1) & NOT_FILE_A, r2 = (n << 2) & NOT_FILE_A & NOT_FILE_B;
+    uint64_t h1 = l1 | r1, h2 = l2 | r2;
+    return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
+}
+
+// Todos los rayos de los deslizantes diagonales y ortogonales de un bando
+static uint64_t slider_fill_scalar(uint64_t diag, uint64_t orth, uint64_t empty) {
+    return slide_fill(diag, empty,  9, NOT_FILE_A) | slide_fill(diag, empty,  7, NOT_FILE_H)
+         | slide_fill(diag, empty, -7, NOT_FILE_A) | slide_fill(diag, empty, -9, NOT_FILE_H)
+         | slide_fill(orth, empty,  8, ~0ULL)      | slide_fill(orth, empty, -8, ~0ULL)
+         | slide_fill(orth, empty,  1, NOT_FILE_A) | slide_fill(orth, empty, -1, NOT_FILE_H);
+}
+
+/* ---------------- Rellenos con AVX2 ----------------
+ * El mismo Kogge-Stone, pero las cuatro direcciones de cada tipo van juntas en
+ * un registro de 256 bits, una por carril de 64. Cada carril desplaza a
+ * izquierda o a derecha según su dirección: el desplazamiento que no le
+ * corresponde vale 64 y vpsllvq/vpsrlvq dan 0 (duplicarlo sigue dando >= 64).
+ * Se compila con target("avx2") y se elige en tiempo de ejecución por CPUID,
+ * así que el binario sigue andando en CPUs sin AVX2.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(CHESS_NO_AVX2)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNEL 1
+
+#define AVX2_FN static inline __attribute__((target("avx2"), always_inline))
+
+AVX2_FN __m256i shift4(__m256i x, __m256i left, __m256i right) {
+    return _mm256_or_si256(_mm256_sllv_epi64(x, left), _mm256_srlv_epi64(x, right));
+}
+
+AVX2_FN __m256i slide_fill4(__m256i gen, __m256i empty, __m256i left, __m256i right, __m256i wrap) {
+    __m256i pro = _mm256_and_si256(empty, wrap);
+    __m256i l = left, r = right;
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift4(gen, l, r)));
+    pro = _mm256_and_si256(pro, shift4(pro, l, r));
+    l = _mm256_add_epi64(l, l); r = _mm256_add_epi64(r, r);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift4(gen, l, r)));
+    pro = _mm256_and_si256(pro, shift4(pro, l, r));
+    l = _mm256_add_epi64(l, l); r = _mm256_add_epi64(r, r);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift4(gen, l, r)));
+    return _mm256_and_si256(shift4(gen, left, right), wrap);
+}
+
+__attribute__((target("avx2")))
+static uint64_t slider_fill_avx2(uint64_t diag, uint64_t orth, uint64_t empty) {
+    // carriles diagonales: NE, SO, NO, SE | ortogonales: N, S, E, O
+    const __m256i leftD  = _mm256_setr_epi64x(9, 64, 7, 64);
+    const __m256i rightD = _mm256_setr_epi64x(64, 9, 64, 7);
+    const __m256i wrapD  = _mm256_setr_epi64x((long long)NOT_FILE_A, (long long)NOT_FILE_H,
+                                              (long long)NOT_FILE_H, (long long)NOT_FILE_A);
+    const __m256i leftO  = _mm256_setr_epi64x(8, 64, 1, 64);
+    const __m256i rightO = _mm256_setr_epi64x(64, 8, 64, 1);
+    const __m256i wrapO  = _mm256_setr_epi64x(-1, -1, (long long)NOT_FILE_A, (long long)NOT_FILE_H);
+
+    __m256i e = _mm256_set1_epi64x((long long)empty);
+    __m256i atk = _mm256_or_si256(
+        slide_fill4(_mm256_set1_epi64x((long long)diag), e, leftD, rightD, wrapD),
+        slide_fill4(_mm256_set1_epi64x((long long)orth), e, leftO, rightO, wrapO));
+    // OR de los cuatro carriles
+    __m128i x = _mm_or_si128(_mm256_castsi256_si128(atk), _mm256_extracti128_si256(atk, 1));
+    x = _mm_or_si128(x, _mm_unpackhi_epi64(x, x));
+    return (uint64_t)_mm_cvtsi128_si64(x);
+}
+#endif
+
+// Despacho: el puntero arranca en el "resolvedor", que mira CPUID la primera
+// vez y se reemplaza a sí mismo por el kernel elegido.
+typedef uint64_t (*SliderFillFn)(uint64_t diag, uint64_t orth, uint64_t empty);
+static uint64_t slider_fill_resolve(uint64_t diag, uint64_t orth, uint64_t empty);
+static SliderFillFn gSliderFill = slider_fill_resolve;
+static int gForceScalar = 0;
+
+static SliderFillFn slider_fill_pick(void) {
+#ifdef HAVE_AVX2_KERNEL
+    __builtin_cpu_init();
+    if (!gForceScalar && __builtin_cpu_supports("avx2")) return slider_fill_avx2;
+#endif
+    return slider_fill_scalar;
+}
+
+static uint64_t slider_fill_resolve(uint64_t diag, uint64_t orth, uint64_t empty) {
+    SliderFillFn f = slider_fill_pick();
+    __atomic_store_n(&gSliderFill, f, __ATOMIC_RELAXED);
+    return f(diag, orth, empty);
+}
+
+const char *board_slider_kernel(void) {
+    return slider_fill_pick() == slider_fill_scalar ? "escalar" : "avx2";
+}
+
+void board_force_scalar(int on) {
+    gForceScalar = on;
+    __atomic_store_n(&gSliderFill, slider_fill_resolve, __ATOMIC_RELAXED);
+}
+
+SIDE_FN uint64_t attack_map(const Position *pos, int side, uint64_t occ) {
+    const uint64_t *b = pos->bb + (side ? WP : BP);
+    uint64_t atk = pawn_attacks(b[WP], side) | knight_fill(b[WN]);
+    STAT_INC(attackMaps);
+
+    uint64_t diag = b[WB] | b[WQ];
+    uint64_t orth = b[WR] | b[WQ];
+    if (diag | orth) atk |= __atomic_load_n(&gSliderFill, __ATOMIC_RELAXED)(diag, orth, ~occ);
+    if (b[WK]) atk |= KING_ATTACKS[__builtin_ctzll(b[WK])];
+    return atk;
+}
+
+// Sólo lee: si el mapa no está en la caché lo calcula sin guardarlo, así una
+// Position const se puede consultar desde varios hilos a la vez.
+SIDE_FN uint64_t attacked_side(const Position *pos, int side) {
+    STAT_INC(attackQueries);
+    if (pos->attacksValid & (1 << side)) return pos->attacks[side];
+    return attack_map(pos, side, occ_all(pos));
+}
+
+uint64_t attacked_squares(const Position *pos, int side) {
+    return side ? attacked_side(pos, 1) : attacked_side(pos, 0);
+}
+
+void position_refresh_attacks(Position *pos) {
+    uint64_t occ = occ_all(pos);
+    pos->attacks[0] = attack_map(pos, 0, occ);
+    pos->attacks[1] = attack_map(pos, 1, occ);
+    pos->attacksValid = 3;
 }
 
 /* ---------------- ¿Casilla atacada por side? ---------------- */
-int is_square_attacked_by_side(int sq, int side) {
-    uint64_t target = bit_at(sq);
-    uint64_t occ = occ_all();
-
-    if (side == 1) { // blancas atacan
-        // peones blancos
-        uint64_t pawnAtk = ((WP & NOT_FILE_A) << 7) | ((WP & NOT_FILE_H) << 9);
-        if (pawnAtk & target) return 1;
-        // caballos
-        uint64_t nBB = WN; while (nBB){ int s=__builtin_ctzll(nBB); nBB&=nBB-1; if (KNIGHT_ATTACKS[s] & target) return 1; }
-        // alfiles/damas (diagonales)
-        uint64_t bBB = WB|WQ; while (bBB){ int s=__builtin_ctzll(bBB); bBB&=bBB-1; if (bishop_attacks_on_the_fly(s, occ) & target) return 1; }
-        // torres/damas (ortogonales)
-        uint64_t rBB = WR|WQ; while (rBB){ int s=__builtin_ctzll(rBB); rBB&=rBB-1; if (rook_attacks_on_the_fly(s, occ) & target) return 1; }
-        // rey
-        if (WK) { int ks = __builtin_ctzll(WK); if (KING_ATTACKS[ks] & target) return 1; }
-    } else { // negras atacan
-        uint64_t pawnAtk = ((BP & NOT_FILE_H) >> 7) | ((BP & NOT_FILE_A) >> 9);
-        if (pawnAtk & target) return 1;
-        uint64_t nBB = BN; while (nBB){ int s=__builtin_ctzll(nBB); nBB&=nBB-1; if (KNIGHT_ATTACKS[s] & target) return 1; }
-        uint64_t bBB = BB|BQ; while (bBB){ int s=__builtin_ctzll(bBB); bBB&=bBB-1; if (bishop_attacks_on_the_fly(s, occ) & target) return 1; }
-        uint64_t rBB = BR|BQ; while (rBB){ int s=__builtin_ctzll(rBB); rBB&=rBB-1; if (rook_attacks_on_the_fly(s, occ) & target) return 1; }
-        if (BK) { int ks = __builtin_ctzll(BK); if (KING_ATTACKS[ks] & target) return 1; }
-    }
-    return 0;
+int is_square_attacked_by_side(const Position *pos, int sq, int side) {
+    return (int)((attacked_squares(pos, side) >> sq) & 1);
 }
 
 /* -------------- Rey en jaque -------------- */
-static int king_square(int side){
-    if (side==1) { if (!WK) return -1; return __builtin_ctzll(WK); }
-    else         { if (!BK) return -1; return __builtin_ctzll(BK); }
+static int king_square(const Position *pos, int side){
+    uint64_t k = pos->bb[side==1 ? WK : BK];
+    if (!k) return -1;
+    return __builtin_ctzll(k);
 }
-int is_king_in_check(int side){
-    int ks = king_square(side);
+int is_king_in_check(const Position *pos, int side){
+    int ks = king_square(pos, side);
     if (ks < 0) return 0; // sin rey (pos irregular)
-    return is_square_attacked_by_side(ks, 1-side);
+    return (attacked_squares(pos, 1-side) & bit_at(ks)) != 0;
 }
 
 /* ---------------- Dispatcher: gen_moves_from (pseudolegal) ---------------- */
-uint64_t gen_moves_from(int sq, int sideToMove) {
-    int code = piece_code_at(sq);
+uint64_t gen_moves_from(const Position *pos, int sq) {
+    int sideToMove = pos->side;
+    int code = piece_code_at(pos, sq);
     if (code == -1) return 0ULL;
     if ((sideToMove==1 && !(code <= 5)) || (sideToMove==0 && !(code >= 6))) return 0ULL;
 
     // Peones
-    if (code == 0 || code == 6) return gen_pawn_from(sq, sideToMove);
+    if (code == 0 || code == 6) return gen_pawn_from(pos, sq, sideToMove);
 
     // Caballos
     if (code == 1 || code == 7) {
-        uint64_t own = (sideToMove==1) ? occ_white() : occ_black();
+        uint64_t own = (sideToMove==1) ? occ_white(pos) : occ_black(pos);
         return KNIGHT_ATTACKS[sq] & ~own;
     }
 
     // Alfiles
     if (code == 2 || code == 8) {
-        uint64_t occ = occ_all();
-        uint64_t own = (sideToMove==1) ? occ_white() : occ_black();
-        uint64_t atk = bishop_attacks_on_the_fly(sq, occ);
+        uint64_t occ = occ_all(pos);
+        uint64_t own = (sideToMove==1) ? occ_white(pos) : occ_black(pos);
+        uint64_t atk = bishop_attacks(sq, occ);
         return atk & ~own;
     }
 
     // Torres
     if (code == 3 || code == 9) {
-        uint64_t occ = occ_all();
-        uint64_t own = (sideToMove==1) ? occ_white() : occ_black();
-        uint64_t atk = rook_attacks_on_the_fly(sq, occ);
+        uint64_t occ = occ_all(pos);
+        uint64_t own = (sideToMove==1) ? occ_white(pos) : occ_black(pos);
+        uint64_t atk = rook_attacks(sq, occ);
         return atk & ~own;
     }
 
     // Dama
     if (code == 4 || code == 10) {
-        uint64_t occ = occ_all();
-        uint64_t own = (sideToMove==1) ? occ_white() : occ_black();
-        uint64_t atkB = bishop_attacks_on_the_fly(sq, occ);
-        uint64_t atkR = rook_attacks_on_the_fly(sq, occ);
+        uint64_t occ = occ_all(pos);
+        uint64_t own = (sideToMove==1) ? occ_white(pos) : occ_black(pos);
+        uint64_t atkB = bishop_attacks(sq, occ);
+        uint64_t atkR = rook_attacks(sq, occ);
         return (atkB | atkR) & ~own;
     }
 
     // Rey (+ enroques con chequeo de casillas atacadas)
     if (code == 5 || code == 11) {
-        uint64_t own = (sideToMove==1) ? occ_white() : occ_black();
-        uint64_t opp = 1 - sideToMove;
-        uint64_t moves = KING_ATTACKS[sq] & ~own;
-
-        // filtrar casillas atacadas (rey no puede entrar en jaque)
-        uint64_t safe = 0ULL;
-        uint64_t tmp = moves;
-        while (tmp) {
-            int tsq = __builtin_ctzll(tmp); tmp &= tmp - 1;
-            if (!is_square_attacked_by_side(tsq, opp)) safe |= bit_at(tsq);
-        }
-        moves = safe;
+        uint64_t own = (sideToMove==1) ? occ_white(pos) : occ_black(pos);
+        uint64_t all = occ_all(pos);
+        // el mapa de ataques rivales (en caché) en vez de consultar casilla por casilla
+        uint64_t danger = attacked_squares(pos, 1 - sideToMove);
+        uint64_t moves = KING_ATTACKS[sq] & ~own & ~danger;
 
         // --- Enroques ---
-        int rights = get_castle_rights();
-        uint64_t all = occ_all();
+        int rights = pos->castle;
 
         if (sideToMove == 1 && sq == square_index(4,0)) { // e1 blanco
             if ((rights & 1) && !(all & (bit_at(5)|bit_at(6))) &&
-                !is_square_attacked_by_side(4, opp) &&
-                !is_square_attacked_by_side(5, opp) &&
-                !is_square_attacked_by_side(6, opp)) {
+                !(danger & (bit_at(4)|bit_at(5)|bit_at(6)))) {
                 moves |= bit_at(6);
             }
             if ((rights & 2) && !(all & (bit_at(3)|bit_at(2)|bit_at(1))) &&
-                !is_square_attacked_by_side(4, opp) &&
-                !is_square_attacked_by_side(3, opp) &&
-                !is_square_attacked_by_side(2, opp)) {
+                !(danger & (bit_at(4)|bit_at(3)|bit_at(2)))) {
                 moves |= bit_at(2);
             }
         } else if (sideToMove == 0 && sq == square_index(4,7)) { // e8 negro
             if ((rights & 4) && !(all & (bit_at(61)|bit_at(62))) &&
-                !is_square_attacked_by_side(60, 1) &&
-                !is_square_attacked_by_side(61, 1) &&
-                !is_square_attacked_by_side(62, 1)) {
+                !(danger & (bit_at(60)|bit_at(61)|bit_at(62)))) {
                 moves |= bit_at(62);
             }
             if ((rights & 8) && !(all & (bit_at(59)|bit_at(58)|bit_at(57))) &&
-                !is_square_attacked_by_side(60, 1) &&
-                !is_square_attacked_by_side(59, 1) &&
-                !is_square_attacked_by_side(58, 1)) {
+                !(danger & (bit_at(60)|bit_at(59)|bit_at(58)))) {
                 moves |= bit_at(58);
             }
         }
@@ -291,174 +380,572 @@ uint64_t gen_moves_from(int sq, int sideToMove) {
     return 0ULL;
 }
 
-/* ---------------- Legales: filtrar pseudolegales ---------------- */
-uint64_t gen_legal_moves_from(int sq, int sideToMove){
-    uint64_t legal = 0ULL;
-    uint64_t pseudo = gen_moves_from(sq, sideToMove);
-    while (pseudo){
-        int toSq = __builtin_ctzll(pseudo);
-        pseudo &= pseudo - 1;
-
-        // snapshot
-        uint64_t savedWP=WP, savedWN=WN, savedWB=WB, savedWR=WR, savedWQ=WQ, savedWK=WK;
-        uint64_t savedBP=BP, savedBN=BN, savedBB=BB, savedBR=BR, savedBQ=BQ, savedBK=BK;
-        int savedEP = get_ep_square();
-        int savedCR = get_castle_rights();
-
-        move_make(sq, toSq, sideToMove, -1);
-        if (!is_king_in_check(sideToMove)) legal |= bit_at(toSq);
-
-        // undo
-        WP=savedWP; WN=savedWN; WB=savedWB; WR=savedWR; WQ=savedWQ; WK=savedWK;
-        BP=savedBP; BN=savedBN; BB=savedBB; BR=savedBR; BQ=savedBQ; BK=savedBK;
-        set_ep_square(savedEP);
-        set_castle_rights(savedCR);
-    }
-    return legal;
+/* ---------------- Lista de movimientos (pseudolegales) ---------------- */
+static inline void push_move(MoveList *list, int fromSq, int toSq, int flags) {
+    list->moves[list->count++] = move_encode(fromSq, toSq, flags);
 }
 
-/* ---------------- Move make con promos + EP + enroque ---------------- */
-static int map_promo(int sideToMove, int promoteCode) {
-    if (promoteCode >= 0) return promoteCode; // ya especificado
-    return (sideToMove==1) ? 4 : 10; // default: dama
+// Serializa destinos de una pieza, marcando capturas
+static inline void push_targets(MoveList *list, int fromSq, uint64_t targets, uint64_t enemy) {
+    while (targets) {
+        int toSq = __builtin_ctzll(targets); targets &= targets - 1;
+        push_move(list, fromSq, toSq, (enemy & bit_at(toSq)) ? MF_CAPTURE : MF_QUIET);
+    }
 }
 
-static void update_castle_rights_on_move(int fromSq, int toSq, int code) {
-    // Si mueve un rey: pierde ambos derechos
-    if (code == 5) { gCastleRights &= ~(1|2); }       // WK,WQ
-    if (code == 11){ gCastleRights &= ~(4|8); }       // BK,BQ
+// Las 4 promociones (N,B,R,Q) con o sin captura
+static inline void push_promos(MoveList *list, int fromSq, int toSq, int capture) {
+    int base = capture ? MF_PROMO_NC : MF_PROMO_N;
+    for (int k = 0; k < 4; ++k) push_move(list, fromSq, toSq, base + k);
+}
 
-    // Si mueve una torre desde su casilla original: pierde ese lado
-    if (code == 3) { // torre blanca
-        if (fromSq == square_index(0,0)) gCastleRights &= ~2; // WQ
-        if (fromSq == square_index(7,0)) gCastleRights &= ~1; // WK
+/* ---------------- Legales: máscaras de jaque y clavadas ----------------
+ * Se calcula una vez por posición:
+ *   - checkers: piezas rivales que dan jaque
+ *   - pinned:   piezas propias clavadas contra el rey
+ *   - danger:   casillas atacadas por el rival (rayos atraviesan al rey)
+ * y con eso sólo se emiten movimientos legales, sin hacer/deshacer.
+ */
+SIDE_FN void gen_legal_side(const Position *pos, MoveList *list, uint64_t fromMask, int us) {
+    STAT_INC(legalGens);
+    const int them = !us;
+    const uint64_t *b  = pos->bb + (us ? WP : BP);     // propias:  b[WP]..b[WK]
+    const uint64_t *bt = pos->bb + (us ? BP : WP);     // rivales: bt[WP]..bt[WK]
+    uint64_t own   = occ_side(pos, us);
+    uint64_t enemy = occ_side(pos, them);
+    uint64_t occ   = own | enemy;
+
+    list->count = 0;
+    if (!b[WK]) return; // sin rey (pos irregular)
+    int ksq = __builtin_ctzll(b[WK]);
+    uint64_t kingM = bit_at(ksq);
+
+    uint64_t theirDiag = bt[WB] | bt[WQ];
+    uint64_t theirOrth = bt[WR] | bt[WQ];
+
+    // Rey: nunca a casillas atacadas. Sin jaque ningún rayo pasa por el rey y
+    // sirve el mapa en caché; en jaque hay que rehacerlo sin el rey en la
+    // ocupación para que no pueda "retroceder" sobre la línea del atacante.
+    uint64_t danger = attacked_side(pos, them);
+    uint64_t checkers = 0ULL;
+    if (danger & kingM) {
+        checkers = (PAWN_ATTACKS[us][ksq] & bt[WP]) |
+                   (KNIGHT_ATTACKS[ksq] & bt[WN]) |
+                   (bishop_attacks(ksq, occ) & theirDiag) |
+                   (rook_attacks(ksq, occ) & theirOrth);
+        danger = attack_map(pos, them, occ ^ kingM);
     }
-    if (code == 9) { // torre negra
-        if (fromSq == square_index(0,7)) gCastleRights &= ~8; // BQ
-        if (fromSq == square_index(7,7)) gCastleRights &= ~4; // BK
+    if (kingM & fromMask) {
+        uint64_t tgt = KING_ATTACKS[ksq] & ~own & ~danger;
+        push_targets(list, ksq, tgt, enemy);
+
+        // Enroques: sin jaque, camino libre y sin atravesar casillas atacadas.
+        // Con derechos el rey está en e1/e8: todas las casillas son constantes.
+        const int kBit = us ? 1 : 4, qBit = us ? 2 : 8, home = us ? 4 : 60;
+        const uint64_t kPath = bit_at(home+1) | bit_at(home+2);
+        const uint64_t qPath = bit_at(home-1) | bit_at(home-2);
+        if (!checkers && (pos->castle & (kBit|qBit))) {
+            if ((pos->castle & kBit) && !(occ & kPath) && !(danger & kPath))
+                push_move(list, home, home+2, MF_CASTLE_K);
+            if ((pos->castle & qBit) && !(occ & (qPath | bit_at(home-3))) && !(danger & qPath))
+                push_move(list, home, home-2, MF_CASTLE_Q);
+        }
     }
 
-    // Si capturamos una torre original rival en su casilla: quita derecho rival
-    if (toSq == square_index(0,0)) gCastleRights &= ~2;
-    if (toSq == square_index(7,0)) gCastleRights &= ~1;
-    if (toSq == square_index(0,7)) gCastleRights &= ~8;
-    if (toSq == square_index(7,7)) gCastleRights &= ~4;
-}
+    // Jaque doble: sólo mueve el rey
+    if (checkers & (checkers - 1)) return;
 
-int move_make(int fromSq, int toSq, int sideToMove, int promoteCode) {
-    if (fromSq<0||fromSq>63||toSq<0||toSq>63) return 0;
+    // Destinos válidos: capturar al que da jaque o interponerse
+    uint64_t checkMask = ~0ULL;
+    if (checkers) {
+        int c = __builtin_ctzll(checkers);
+        checkMask = checkers | BETWEEN[ksq][c];
+    }
 
-    int code = piece_code_at(fromSq);
-    if (code == -1) return 0;
-    int isWhite = (code <= 5);
-    if ((sideToMove==1 && !isWhite) || (sideToMove==0 && isWhite)) return 0;
+    // Clavadas: deslizantes rivales alineados con el rey con una sola pieza en medio
+    uint64_t pinned = 0ULL;
+    uint64_t snipers = (bishop_attacks(ksq, 0ULL) & theirDiag) | (rook_attacks(ksq, 0ULL) & theirOrth);
+    while (snipers) {
+        int s = __builtin_ctzll(snipers); snipers &= snipers - 1;
+        uint64_t between = BETWEEN[ksq][s] & occ;
+        if (between && !(between & (between - 1)) && (between & own)) pinned |= between;
+    }
 
-    uint64_t fromM = bit_at(fromSq), toM = bit_at(toSq);
-    int isPawn = (code==0 || code==6);
-
-    // --- Enroques (mueve el rey de e1/e8 a g/c) ---
-    if (code == 5 && fromSq == square_index(4,0)) { // rey blanco
-        if (toSq == square_index(6,0)) { // O-O
-            WK &= ~fromM; WK |= toM;
-            WR &= ~bit_at(square_index(7,0));
-            WR |= bit_at(square_index(5,0));
-            gCastleRights &= ~(1|2);
-            clear_ep_square();
-            return 1;
-        }
-        if (toSq == square_index(2,0)) { // O-O-O
-            WK &= ~fromM; WK |= toM;
-            WR &= ~bit_at(square_index(0,0));
-            WR |= bit_at(square_index(3,0));
-            gCastleRights &= ~(1|2);
-            clear_ep_square();
-            return 1;
+    uint64_t targetMask = ~own & checkMask;
+
+    // Peones
+    uint64_t pawns = b[WP] & fromMask;
+    const int promoRank = us ? 7 : 0, startRank = us ? 1 : 6, fwd = us ? 8 : -8;
+    while (pawns) {
+        int sq = __builtin_ctzll(pawns); pawns &= pawns - 1;
+        uint64_t m = bit_at(sq);
+        uint64_t pinLine = (pinned & m) ? LINE[ksq][sq] : ~0ULL;
+        int one = sq + fwd;
+
+        if (!(occ & bit_at(one))) {
+            if (bit_at(one) & checkMask & pinLine) {
+                if (one / 8 == promoRank) push_promos(list, sq, one, 0);
+                else push_move(list, sq, one, MF_QUIET);
+            }
+            if (sq / 8 == startRank && !(occ & bit_at(one + fwd)) && (bit_at(one + fwd) & checkMask & pinLine))
+                push_move(list, sq, one + fwd, MF_DOUBLE_PUSH);
         }
-    }
-    if (code == 11 && fromSq == square_index(4,7)) { // rey negro
-        if (toSq == square_index(6,7)) { // O-O
-            BK &= ~fromM; BK |= toM;
-            BR &= ~bit_at(square_index(7,7));
-            BR |= bit_at(square_index(5,7));
-            gCastleRights &= ~(4|8);
-            clear_ep_square();
-            return 1;
+        uint64_t atk = PAWN_ATTACKS[us][sq];
+        uint64_t caps = atk & enemy & checkMask & pinLine;
+        while (caps) {
+            int toSq = __builtin_ctzll(caps); caps &= caps - 1;
+            if (toSq / 8 == promoRank) push_promos(list, sq, toSq, 1);
+            else push_move(list, sq, toSq, MF_CAPTURE);
         }
-        if (toSq == square_index(2,7)) { // O-O-O
-            BK &= ~fromM; BK |= toM;
-            BR &= ~bit_at(square_index(0,7));
-            BR |= bit_at(square_index(3,7));
-            gCastleRights &= ~(4|8);
-            clear_ep_square();
-            return 1;
+
+        // En passant: el peón capturado puede ser el que da jaque, y al
+        // salir los dos peones de la fila puede quedar un jaque descubierto.
+        if (pos->ep != -1 && (atk & bit_at(pos->ep))) {
+            int capSq = pos->ep - fwd;
+            if ((checkMask & (bit_at(pos->ep) | bit_at(capSq))) && (bit_at(pos->ep) & pinLine)) {
+                uint64_t occAfter = (occ ^ m ^ bit_at(capSq)) | bit_at(pos->ep);
+                if (!(rook_attacks(ksq, occAfter) & theirOrth) && !(bishop_attacks(ksq, occAfter) & theirDiag))
+                    push_move(list, sq, pos->ep, MF_EP);
+            }
         }
     }
 
-    // en passant
-    if (isPawn && get_ep_square() != -1 && toSq == get_ep_square()) {
-        *piece_bb[code] &= ~fromM;
-        *piece_bb[code] |= toM;
-        if (isWhite) { *piece_bb[6] &= ~bit_at(toSq-8); } // quita peón negro
-        else         { *piece_bb[0] &= ~bit_at(toSq+8); } // quita peón blanco
-        clear_ep_square();
-        update_castle_rights_on_move(fromSq, toSq, code);
-        return 1;
+    // Caballos (uno clavado nunca se puede mover)
+    uint64_t pcs = b[WN] & fromMask & ~pinned;
+    while (pcs) { int sq = __builtin_ctzll(pcs); pcs &= pcs - 1; push_targets(list, sq, KNIGHT_ATTACKS[sq] & targetMask, enemy); }
+
+    // Alfiles / torres / damas (clavados: sólo sobre la línea del rey)
+    pcs = (b[WB] | b[WQ]) & fromMask;
+    while (pcs) {
+        int sq = __builtin_ctzll(pcs); pcs &= pcs - 1;
+        uint64_t tgt = bishop_attacks(sq, occ) & targetMask;
+        if (pinned & bit_at(sq)) tgt &= LINE[ksq][sq];
+        push_targets(list, sq, tgt, enemy);
+    }
+    pcs = (b[WR] | b[WQ]) & fromMask;
+    while (pcs) {
+        int sq = __builtin_ctzll(pcs); pcs &= pcs - 1;
+        uint64_t tgt = rook_attacks(sq, occ) & targetMask;
+        if (pinned & bit_at(sq)) tgt &= LINE[ksq][sq];
+        push_targets(list, sq, tgt, enemy);
     }
+}
+
+static void gen_legal_moves_mask(const Position *pos, MoveList *list, uint64_t fromMask) {
+    if (pos->side) gen_legal_side(pos, list, fromMask, 1);
+    else           gen_legal_side(pos, list, fromMask, 0);
+}
 
-    // captura normal (eliminar destino enemigo primero)
-    if (isWhite) { for (int i=6;i<=11;i++) *piece_bb[i] &= ~toM; }
-    else         { for (int i=0;i<=5; i++) *piece_bb[i] &= ~toM; }
+void gen_legal_moves(const Position *pos, MoveList *list) {
+    gen_legal_moves_mask(pos, list, ~0ULL);
+}
 
-    // quitar del origen
-    *piece_bb[code] &= ~fromM;
+uint64_t gen_legal_moves_from(const Position *pos, int sq){
+    STAT_INC(legalFrom);
+    MoveList list;
+    gen_legal_moves_mask(pos, &list, bit_at(sq));
+    uint64_t legal = 0ULL;
+    for (int i = 0; i < list.count; ++i) legal |= bit_at(move_to(list.moves[i]));
+    return legal;
+}
 
-    int toRank = toSq / 8;
-    if (isPawn) {
-        int promote = -1;
-        if (isWhite && toRank==7) promote = map_promo(1, promoteCode);
-        else if (!isWhite && toRank==0) promote = map_promo(0, promoteCode);
+Move move_find(const Position *pos, int fromSq, int toSq, int promoteCode) {
+    if (fromSq<0||fromSq>63||toSq<0||toSq>63) return MOVE_NONE;
+
+    MoveList list;
+    gen_legal_moves_mask(pos, &list, bit_at(fromSq));
+    int promo = (promoteCode >= 0) ? promoteCode : (pos->side==1 ? WQ : BQ); // default: dama
+    for (int i = 0; i < list.count; ++i) {
+        Move m = list.moves[i];
+        if (move_to(m) != toSq) continue;
+        if (move_is_promo(m) && move_promo_code(m, pos->side) != promo) continue;
+        return m;
+    }
+    return MOVE_NONE;
+}
 
-        if (promote!=-1) *piece_bb[promote] |= toM;
-        else             *piece_bb[code]    |= toM;
+/* ---------------- Move make con promos + EP + enroque ---------------- */
+// Con CHESS_DEBUG_HASH se compara el hash incremental contra uno desde cero.
+// No usa assert: el build Release define NDEBUG y la comprobación desaparecería.
+#ifdef CHESS_DEBUG_HASH
+#define CHECK_KEY(pos) do { \
+    uint64_t want_ = position_compute_key(pos); \
+    if ((pos)->key != want_) { \
+        fprintf(stderr, "hash Zobrist desincronizado: %016llx, desde cero %016llx\n", \
+                (unsigned long long)(pos)->key, (unsigned long long)want_); \
+        abort(); \
+    } \
+} while (0)
+#else
+#define CHECK_KEY(pos) ((void)0)
+#endif
+
+// Derechos de enroque que sobreviven a que algo salga de o llegue a cada
+// casilla: mover el rey o una torre desde su casilla original, o capturar una
+// torre original rival, quita el derecho correspondiente. Con derechos, en
+// esas casillas sólo puede estar el rey o la torre, así que basta la casilla.
+static const uint8_t CASTLE_KEEP[64] = {
+    13, 15, 15, 15, 12, 15, 15, 14,   // a1: -WQ, e1: -WK-WQ, h1: -WK
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+     7, 15, 15, 15,  3, 15, 15, 11,   // a8: -BQ, e8: -BK-BQ, h8: -BK
+};
+
+// Casillas de la torre en un enroque de 'us' (según el flag de la jugada)
+SIDE_FN void castle_rook_squares(int flags, int us, int *rookFrom, int *rookTo) {
+    const int base = us ? 0 : 56;
+    *rookFrom = base + (flags == MF_CASTLE_K ? 7 : 0);
+    *rookTo   = base + (flags == MF_CASTLE_K ? 5 : 3);
+}
 
-        // EP
-        int fromRank = fromSq/8;
-        if (isWhite && fromRank==1 && toRank==3) set_ep_square(fromSq+8);
-        else if (!isWhite && fromRank==6 && toRank==4) set_ep_square(fromSq-8);
-        else clear_ep_square();
-    } else {
-        *piece_bb[code] |= toM;
-        clear_ep_square();
+// 'res' sólo lo pasa move_make_result: en move_make es NULL constante y,
+// al expandirse en línea, todo lo de 'res' desaparece.
+SIDE_FN void move_make_side(Position *pos, Move mv, Undo *u, MoveResult *res, int us) {
+    STAT_INC(makes);
+    int fromSq = move_from(mv), toSq = move_to(mv), flags = move_flags(mv);
+    int code = pos->mailbox[fromSq];
+    uint64_t *b = pos->bb;
+    int8_t *mb = pos->mailbox;
+    uint64_t fromM = bit_at(fromSq), toM = bit_at(toSq);
+
+    if (res) {
+        res->moved = res->placed = (int8_t)code;
+        res->captured = res->capturedSq = -1;
+        res->rookFrom = res->rookTo = -1;
+        res->promo = -1;
+    }
+    if (u) {
+        u->captured = -1; // se completa abajo si hay captura
+        u->ep       = (int8_t)pos->ep;
+        u->castle   = (int8_t)pos->castle;
+        u->halfmove = (int16_t)pos->halfmove;
+        u->key      = pos->key;
     }
 
-    update_castle_rights_on_move(fromSq, toSq, code);
+    // hash: turno, EP y enroques viejos fuera (lo nuevo se suma al final)
+    uint64_t key = pos->key ^ ZOBRIST_SIDE ^ ZOBRIST_CASTLE[pos->castle];
+    if (pos->ep != -1) key ^= ZOBRIST_EP[pos->ep % 8];
+
+    pos->side = !us;
+    pos->ep = -1;
+    // contadores: captura o peón reinicia la regla de 50
+    pos->halfmove = ((flags & MF_CAPTURE) || code == (us ? WP : BP)) ? 0 : pos->halfmove + 1;
+    pos->fullmove += !us;
+
+    // capturas: el mailbox dice qué bitboard tocar
+    if (flags == MF_EP) {
+        int capSq = toSq - (us ? 8 : -8);
+        const int cap = us ? BP : WP;
+        b[cap] &= ~bit_at(capSq);
+        mb[capSq] = -1;
+        key ^= ZOBRIST_PIECE[cap][capSq];
+        if (u) u->captured = (int8_t)cap;
+        if (res) { res->captured = (int8_t)cap; res->capturedSq = (int8_t)capSq; }
+    } else if (flags & MF_CAPTURE) {
+        int cap = mb[toSq];
+        b[cap] &= ~toM;
+        key ^= ZOBRIST_PIECE[cap][toSq];
+        if (u) u->captured = (int8_t)cap;
+        if (res) { res->captured = (int8_t)cap; res->capturedSq = (int8_t)toSq; }
+    }
+
+    // mover (o promocionar)
+    int placed = (flags & MF_PROMO) ? move_promo_code(mv, us) : code;
+    b[code] &= ~fromM;
+    b[placed] |= toM;
+    mb[fromSq] = -1;
+    mb[toSq] = (int8_t)placed;
+    key ^= ZOBRIST_PIECE[code][fromSq] ^ ZOBRIST_PIECE[placed][toSq];
+    if (res) {
+        res->placed = (int8_t)placed;
+        if (flags & MF_PROMO) res->promo = (int8_t)placed;
+    }
+
+    if (flags == MF_DOUBLE_PUSH) {
+        pos->ep = fromSq + (us ? 8 : -8);
+        key ^= ZOBRIST_EP[fromSq % 8];
+    } else if (flags == MF_CASTLE_K || flags == MF_CASTLE_Q) {
+        int rookFrom, rookTo;
+        castle_rook_squares(flags, us, &rookFrom, &rookTo);
+        const int rook = us ? WR : BR;
+        b[rook] ^= bit_at(rookFrom) | bit_at(rookTo);
+        mb[rookFrom] = -1;
+        mb[rookTo] = (int8_t)rook;
+        key ^= ZOBRIST_PIECE[rook][rookFrom] ^ ZOBRIST_PIECE[rook][rookTo];
+        if (res) { res->rookFrom = (int8_t)rookFrom; res->rookTo = (int8_t)rookTo; }
+    }
+
+    pos->castle &= CASTLE_KEEP[fromSq] & CASTLE_KEEP[toSq];
+    pos->key = key ^ ZOBRIST_CASTLE[pos->castle];
+    CHECK_KEY(pos);
+
+    // el mapa de ataques de 'us' queda en la caché: la generación legal del
+    // rival lo usa como casillas prohibidas para su rey, no se calcula dos veces
+    pos->attacks[us] = attack_map(pos, us, occ_all(pos));
+    pos->attacksValid = 1 << us;
+    if (res) res->givesCheck = (int8_t)((pos->attacks[us] & b[us ? BK : WK]) != 0);
+}
+
+int move_make(Position *pos, Move mv, Undo *u) {
+    if (mv == MOVE_NONE) return 0;
+    int code = pos->mailbox[move_from(mv)];
+    if (code == -1) return 0;
+    if ((code <= 5) != (pos->side == 1)) return 0; // pieza del bando que no mueve
+    if (pos->side) move_make_side(pos, mv, u, NULL, 1);
+    else           move_make_side(pos, mv, u, NULL, 0);
+    return 1;
+}
+
+int move_make_result(Position *pos, Move mv, Undo *u, MoveResult *res) {
+    if (mv == MOVE_NONE) return 0;
+    int code = pos->mailbox[move_from(mv)];
+    if (code == -1) return 0;
+    if ((code <= 5) != (pos->side == 1)) return 0;
+    if (pos->side) move_make_side(pos, mv, u, res, 1);
+    else           move_make_side(pos, mv, u, res, 0);
     return 1;
 }
 
+SIDE_FN void move_unmake_side(Position *pos, Move mv, const Undo *u, int us) {
+    int fromSq = move_from(mv), toSq = move_to(mv), flags = move_flags(mv);
+    uint64_t *b = pos->bb;
+    int8_t *mb = pos->mailbox;
+
+    pos->side   = us;
+    pos->ep     = u->ep;
+    pos->castle = u->castle;
+    pos->halfmove = u->halfmove;
+    pos->fullmove -= !us;
+    pos->key    = u->key;
+    pos->attacksValid = 0;
+
+    // sacar del destino lo que haya quedado (pieza movida o promocionada)
+    int now = mb[toSq];
+    int code = (flags & MF_PROMO) ? (us ? WP : BP) : now;
+    b[now] &= ~bit_at(toSq);
+    b[code] |= bit_at(fromSq);
+    mb[toSq] = -1;
+    mb[fromSq] = (int8_t)code;
+
+    if (flags == MF_CASTLE_K || flags == MF_CASTLE_Q) {
+        int rookFrom, rookTo;
+        castle_rook_squares(flags, us, &rookFrom, &rookTo);
+        const int rook = us ? WR : BR;
+        b[rook] ^= bit_at(rookFrom) | bit_at(rookTo);
+        mb[rookTo] = -1;
+        mb[rookFrom] = (int8_t)rook;
+    } else if (u->captured >= 0) {
+        // en passant: el peón capturado estaba detrás del destino
+        int capSq = (flags == MF_EP) ? toSq - (us ? 8 : -8) : toSq;
+        b[u->captured] |= bit_at(capSq);
+        mb[capSq] = u->captured;
+    }
+    CHECK_KEY(pos);
+}
+
+void move_unmake(Position *pos, Move mv, const Undo *u) {
+    if (pos->side) move_unmake_side(pos, mv, u, 0); // movió el otro bando
+    else           move_unmake_side(pos, mv, u, 1);
+}
+
+// Reconstruye el mailbox desde los bitboards (tras cargar una posición)
+static void mailbox_from_bitboards(Position *pos) {
+    for (int sq = 0; sq < 64; ++sq) pos->mailbox[sq] = -1;
+    for (int code = WP; code <= BK; ++code) {
+        uint64_t bbc = pos->bb[code];
+        while (bbc) { int sq = __builtin_ctzll(bbc); bbc &= bbc - 1; pos->mailbox[sq] = (int8_t)code; }
+    }
+}
+
 /* ---------------- Posición inicial ---------------- */
-void board_init_startpos(void){
-    WP = WN = WB = WR = WQ = WK = 0ULL;
-    BP = BN = BB = BR = BQ = BK = 0ULL;
+void board_init_startpos(Position *pos){
+    uint64_t *b = pos->bb;
+    for (int i = 0; i < 12; ++i) b[i] = 0ULL;
 
     for (int f=0; f<8; f++) {
-        WP |= bit_at(square_index(f,1));
-        BP |= bit_at(square_index(f,6));
+        b[WP] |= bit_at(square_index(f,1));
+        b[BP] |= bit_at(square_index(f,6));
     }
-    WR |= bit_at(square_index(0,0)) | bit_at(square_index(7,0));
-    WN |= bit_at(square_index(1,0)) | bit_at(square_index(6,0));
-    WB |= bit_at(square_index(2,0)) | bit_at(square_index(5,0));
-    WQ |= bit_at(square_index(3,0));
-    WK |= bit_at(square_index(4,0));
+    b[WR] |= bit_at(square_index(0,0)) | bit_at(square_index(7,0));
+    b[WN] |= bit_at(square_index(1,0)) | bit_at(square_index(6,0));
+    b[WB] |= bit_at(square_index(2,0)) | bit_at(square_index(5,0));
+    b[WQ] |= bit_at(square_index(3,0));
+    b[WK] |= bit_at(square_index(4,0));
+
+    b[BR] |= bit_at(square_index(0,7)) | bit_at(square_index(7,7));
+    b[BN] |= bit_at(square_index(1,7)) | bit_at(square_index(6,7));
+    b[BB] |= bit_at(square_index(2,7)) | bit_at(square_index(5,7));
+    b[BQ] |= bit_at(square_index(3,7));
+    b[BK] |= bit_at(square_index(4,7));
+
+    mailbox_from_bitboards(pos);
+    pos->side = 1;
+    clear_ep_square(pos);
+    set_castle_rights(pos, 1|2|4|8); // WK|WQ|BK|BQ habilitados al inicio
+    pos->halfmove = 0;
+    pos->fullmove = 1;
+    pos->key = position_compute_key(pos);
+    position_refresh_attacks(pos);
+}
+
+/* ---------------- FEN ---------------- */
 
-    BR |= bit_at(square_index(0,7)) | bit_at(square_index(7,7));
-    BN |= bit_at(square_index(1,7)) | bit_at(square_index(6,7));
-    BB |= bit_at(square_index(2,7)) | bit_at(square_index(5,7));
-    BQ |= bit_at(square_index(3,7));
-    BK |= bit_at(square_index(4,7));
+static const uint64_t RANK_1 = 0x00000000000000FFULL;
+static const uint64_t RANK_8 = 0xFF00000000000000ULL;
 
-    clear_ep_square();
-    set_castle_rights(1|2|4|8); // WK|WQ|BK|BQ habilitados al inicio
-    board_init_attacks();       // init caballo+rey
+static int fen_piece_code(char c) {
+    switch (c) {
+        case 'P': return WP; case 'N': return WN; case 'B': return WB;
+        case 'R': return WR; case 'Q': return WQ; case 'K': return WK;
+        case 'p': return BP; case 'n': return BN; case 'b': return BB;
+        case 'r': return BR; case 'q': return BQ; case 'k': return BK;
+        default:  return -1;
+    }
+}
+
+// Entero decimal en [0, maxVal]; avanza *s. -1 si no hay dígitos o se pasa.
+static int fen_read_uint(const char **s, int maxVal) {
+    const char *c = *s;
+    if (*c < '0' || *c > '9') return -1;
+    int v = 0;
+    for (; *c >= '0' && *c <= '9'; ++c) {
+        v = v * 10 + (*c - '0');
+        if (v > maxVal) return -1;
+    }
+    *s = c;
+    return v;
+}
+
+int position_from_fen(Position *pos, const char *fen) {
+    if (!fen) return 0;
+
+    // Se arma en una copia local: si algo falla, 'pos' no cambia
+    Position p;
+    memset(&p, 0, sizeof(p));
+    memset(p.mailbox, -1, sizeof(p.mailbox));
+    const char *c = fen;
+    while (*c == ' ') c++;
+
+    // 1) piezas, desde la fila 8; cada fila suma exactamente 8
+    for (int rank = 7; rank >= 0; --rank) {
+        int file = 0;
+        while (file < 8) {
+            char ch = *c++;
+            if (ch >= '1' && ch <= '8') { file += ch - '0'; continue; }
+            int code = fen_piece_code(ch); // '\0' también cae acá
+            if (code < 0) return 0;
+            int sq = square_index(file++, rank);
+            p.bb[code] |= bit_at(sq);
+            p.mailbox[sq] = (int8_t)code;
+        }
+        if (file != 8) return 0;
+        if (rank > 0 && *c++ != '/') return 0;
+    }
+
+    // 2) turno
+    if (*c++ != ' ') return 0;
+    if      (*c == 'w') p.side = 1;
+    else if (*c == 'b') p.side = 0;
+    else return 0;
+    c++;
+
+    // 3) enroques: "-" o letras de "KQkq" sin repetir
+    if (*c++ != ' ') return 0;
+    if (*c == '-') c++;
+    else {
+        for (; *c && *c != ' '; ++c) {
+            int bit = *c == 'K' ? 1 : *c == 'Q' ? 2 : *c == 'k' ? 4 : *c == 'q' ? 8 : 0;
+            if (!bit || (p.castle & bit)) return 0;
+            p.castle |= bit;
+        }
+        if (!p.castle) return 0;
+    }
+
+    // 4) EP
+    if (*c++ != ' ') return 0;
+    p.ep = -1;
+    if (*c == '-') c++;
+    else {
+        if (c[0] < 'a' || c[0] > 'h' || c[1] < '1' || c[1] > '8') return 0;
+        p.ep = square_index(c[0] - 'a', c[1] - '1');
+        c += 2;
+    }
+
+    // 5) contadores, opcionales; lo que siga (operaciones EPD) se ignora
+    p.halfmove = 0;
+    p.fullmove = 1;
+    if (*c && *c != ' ') return 0;
+    while (*c == ' ') c++;
+    if (*c >= '0' && *c <= '9') {
+        if ((p.halfmove = fen_read_uint(&c, 9999)) < 0) return 0;
+        if (c[0] == ' ' && c[1] >= '0' && c[1] <= '9') {
+            c++;
+            if ((p.fullmove = fen_read_uint(&c, 99999)) < 0) return 0;
+            if (p.fullmove == 0) p.fullmove = 1; // algunos generadores escriben 0
+        }
+        if (*c && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n') return 0;
+    }
+
+    // 6) que la posición sea posible
+    const uint64_t *b = p.bb;
+    if (__builtin_popcountll(b[WK]) != 1 || __builtin_popcountll(b[BK]) != 1) return 0;
+    if ((b[WP] | b[BP]) & (RANK_1 | RANK_8)) return 0;
+    if ((p.castle & 3)  && !(b[WK] & bit_at(4)))  return 0;
+    if ((p.castle & 1)  && !(b[WR] & bit_at(7)))  return 0;
+    if ((p.castle & 2)  && !(b[WR] & bit_at(0)))  return 0;
+    if ((p.castle & 12) && !(b[BK] & bit_at(60))) return 0;
+    if ((p.castle & 4)  && !(b[BR] & bit_at(63))) return 0;
+    if ((p.castle & 8)  && !(b[BR] & bit_at(56))) return 0;
+    if (p.ep != -1) {
+        // el rival acaba de hacer el doble paso: casilla EP y origen vacíos, peón delante
+        int pawnSq = p.side == 1 ? p.ep - 8 : p.ep + 8;
+        int fromSq = p.side == 1 ? p.ep + 8 : p.ep - 8;
+        if (p.ep / 8 != (p.side == 1 ? 5 : 2)) return 0;
+        if (p.mailbox[p.ep] != -1 || p.mailbox[fromSq] != -1) return 0;
+        if (p.mailbox[pawnSq] != (p.side == 1 ? BP : WP)) return 0;
+    }
+    if (is_king_in_check(&p, 1 - p.side)) return 0;
+
+    p.key = position_compute_key(&p);
+    position_refresh_attacks(&p);
+    *pos = p;
+    return 1;
+}
+
+int position_to_fen(const Position *pos, char out[FEN_MAX]) {
+    static const char PIECES[] = "PNBRQKpnbrqk";
+    char *o = out;
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            int code = pos->mailbox[square_index(file, rank)];
+            if (code < 0) { empty++; continue; }
+            if (empty) { *o++ = (char)('0' + empty); empty = 0; }
+            *o++ = PIECES[code];
+        }
+        if (empty) *o++ = (char)('0' + empty);
+        if (rank > 0) *o++ = '/';
+    }
+
+    *o++ = ' ';
+    *o++ = pos->side == 1 ? 'w' : 'b';
+    *o++ = ' ';
+    if (!pos->castle) *o++ = '-';
+    for (int i = 0; i < 4; ++i)
+        if (pos->castle & (1 << i)) *o++ = "KQkq"[i];
+    *o++ = ' ';
+    if (pos->ep == -1) *o++ = '-';
+    else { *o++ = (char)('a' + pos->ep % 8); *o++ = (char)('1' + pos->ep / 8); }
+
+    // contadores acotados para que siempre entre en FEN_MAX
+    int half = pos->halfmove < 0 ? 0 : pos->halfmove > 9999 ? 9999 : pos->halfmove;
+    int full = pos->fullmove < 1 ? 1 : pos->fullmove > 99999 ? 99999 : pos->fullmove;
+    o += snprintf(o, (size_t)(FEN_MAX - (o - out)), " %d %d", half, full);
+    return (int)(o - out);
 }
 
 /* ---------------- Perft (legal) y divide ---------------- */
@@ -468,76 +955,137 @@ static void sq_to_coord(int sq, char out[3]) {
     int file = sq % 8, rank = sq / 8;
     out[0] = 'a' + file; out[1] = '1' + rank; out[2] = '\0';
 }
-static void move_to_uci(int fromSq, int toSq, char out[6]) {
-    char a[3], b[3]; sq_to_coord(fromSq, a); sq_to_coord(toSq, b);
+void move_to_uci(Move m, char out[6]) {
+    char a[3], b[3]; sq_to_coord(move_from(m), a); sq_to_coord(move_to(m), b);
     out[0]=a[0]; out[1]=a[1]; out[2]=b[0]; out[3]=b[1]; out[4]='\0';
+    if (move_is_promo(m)) { out[4] = "nbrq"[move_flags(m) & 3]; out[5] = '\0'; }
 }
 
-uint64_t perft(int depth, int sideToMove) {
-    if (depth == 0) return 1ULL;
-    uint64_t nodes = 0ULL;
+// Una copia por bando: cada nodo genera, hace y deshace sin mirar pos->side
+// y llama directo a la del rival.
+static uint64_t perft_white(Position *pos, int depth);
+static uint64_t perft_black(Position *pos, int depth);
 
-    for (int sq = 0; sq < 64; ++sq) {
-        if (piece_code_at(sq) == -1) continue;
-        if ((sideToMove==1 && !is_white_at(sq)) ||
-            (sideToMove==0 && !is_black_at(sq))) continue;
-
-        uint64_t moves = gen_legal_moves_from(sq, sideToMove);
-        while (moves) {
-            int toSq = __builtin_ctzll(moves); moves &= moves - 1;
-
-            // snapshot
-            uint64_t savedWP=WP, savedWN=WN, savedWB=WB, savedWR=WR, savedWQ=WQ, savedWK=WK;
-            uint64_t savedBP=BP, savedBN=BN, savedBB=BB, savedBR=BR, savedBQ=BQ, savedBK=BK;
-            int savedEP = get_ep_square();
-            int savedCR = get_castle_rights();
-
-            move_make(sq, toSq, sideToMove, -1);
-            nodes += perft(depth-1, 1-sideToMove);
-
-            // undo
-            WP=savedWP; WN=savedWN; WB=savedWB; WR=savedWR; WQ=savedWQ; WK=savedWK;
-            BP=savedBP; BN=savedBN; BB=savedBB; BR=savedBR; BQ=savedBQ; BK=savedBK;
-            set_ep_square(savedEP);
-            set_castle_rights(savedCR);
-        }
+SIDE_FN uint64_t perft_side(Position *pos, int depth, int us) {
+    MoveList list;
+    gen_legal_side(pos, &list, ~0ULL, us);
+    if (depth == 1) return (uint64_t)list.count; // bulk counting
+
+    uint64_t nodes = 0ULL;
+    for (int i = 0; i < list.count; ++i) {
+        Undo u;
+        move_make_side(pos, list.moves[i], &u, NULL, us);
+        nodes += us ? perft_black(pos, depth-1) : perft_white(pos, depth-1);
+        move_unmake_side(pos, list.moves[i], &u, us);
     }
     return nodes;
 }
 
-void perft_divide(int depth, int sideToMove) {
+static uint64_t perft_white(Position *pos, int depth) { return perft_side(pos, depth, 1); }
+static uint64_t perft_black(Position *pos, int depth) { return perft_side(pos, depth, 0); }
+
+uint64_t perft(Position *pos, int depth) {
+    if (depth == 0) return 1ULL;
+    return pos->side ? perft_white(pos, depth) : perft_black(pos, depth);
+}
+
+void perft_divide(Position *pos, int depth) {
     if (depth <= 0) { printf("depth debe ser >= 1\n"); return; }
 
     uint64_t total = 0ULL;
+    MoveList list;
+    gen_legal_moves(pos, &list);
 
-    for (int sq = 0; sq < 64; ++sq) {
-        if (piece_code_at(sq) == -1) continue;
-        if ((sideToMove==1 && !is_white_at(sq)) ||
-            (sideToMove==0 && !is_black_at(sq))) continue;
-
-        uint64_t moves = gen_legal_moves_from(sq, sideToMove);
-        while (moves) {
-            int toSq = __builtin_ctzll(moves); moves &= moves - 1;
-
-            // snapshot
-            uint64_t savedWP=WP, savedWN=WN, savedWB=WB, savedWR=WR, savedWQ=WQ, savedWK=WK;
-            uint64_t savedBP=BP, savedBN=BN, savedBB=BB, savedBR=BR, savedBQ=BQ, savedBK=BK;
-            int savedEP = get_ep_square();
-            int savedCR = get_castle_rights();
-
-            move_make(sq, toSq, sideToMove, -1);
-            uint64_t n = perft(depth-1, 1-sideToMove);
-            total += n;
-
-            char uci[6]; move_to_uci(sq, toSq, uci);
-            printf("%s: %llu\n", uci, (unsigned long long)n);
-
-            // undo
-            WP=savedWP; WN=savedWN; WB=savedWB; WR=savedWR; WQ=savedWQ; WK=savedWK;
-            BP=savedBP; BN=savedBN; BB=savedBB; BR=savedBR; BQ=savedBQ; BK=savedBK;
-            set_ep_square(savedEP);
-            set_castle_rights(savedCR);
-        }
+    for (int i = 0; i < list.count; ++i) {
+        Undo u;
+        move_make(pos, list.moves[i], &u);
+        uint64_t n = perft(pos, depth-1);
+        total += n;
+
+        char uci[6]; move_to_uci(list.moves[i], uci);
+        printf("%s: %llu\n", uci, (unsigned long long)n);
+
+        move_unmake(pos, list.moves[i], &u);
     }
     printf("Total: %llu\n", (unsigned long long)total);
 }
+
+/* ---------------- Perft con tabla hash ---------------- */
+int perft_table_init(PerftTable *t, size_t megabytes) {
+    size_t bytes = megabytes * 1024 * 1024;
+    uint64_t n = 1;
+    while (n * 2 * sizeof(PerftEntry) <= bytes) n *= 2;
+
+    t->entries = (PerftEntry*)calloc(n, sizeof(PerftEntry));
+    t->mask = n - 1;
+    t->probes = t->hits = 0;
+    return t->entries != NULL;
+}
+
+void perft_table_clear(PerftTable *t) {
+    memset(t->entries, 0, (t->mask + 1) * sizeof(PerftEntry));
+    t->probes = t->hits = 0;
+}
+
+void perft_table_free(PerftTable *t) {
+    free(t->entries);
+    t->entries = NULL;
+    t->mask = 0;
+}
+
+// La tabla se comparte entre hilos sin locks: accesos atómicos relajados
+// (como en tt.c); el XOR de 'check' descarta las entradas mezcladas.
+static inline uint64_t pt_load(const uint64_t *p)      { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+static inline void     pt_store(uint64_t *p, uint64_t v) { __atomic_store_n(p, v, __ATOMIC_RELAXED); }
+
+// La profundidad se mezcla en el hash: misma posición a distinta
+// profundidad va a otra entrada.
+static inline uint64_t perft_slot_key(uint64_t key, int depth) {
+    return key ^ ((uint64_t)depth * 0x9E3779B97F4A7C15ULL);
+}
+
+uint64_t perft_hashed(Position *pos, int depth, PerftTable *t) {
+    if (!t) return perft(pos, depth);
+    if (depth <= 1) return perft(pos, depth); // bulk counting: no vale la pena guardar
+
+    uint64_t k = perft_slot_key(pos->key, depth);
+    PerftEntry *e = &t->entries[k & t->mask];
+    t->probes++;
+    uint64_t data = pt_load(&e->data);
+    if ((pt_load(&e->check) ^ data) == k && (int)(data & 0xFF) == depth) {
+        t->hits++;
+        return data >> 8;
+    }
+
+    MoveList list;
+    gen_legal_moves(pos, &list);
+    uint64_t nodes = 0ULL;
+    for (int i = 0; i < list.count; ++i) {
+        Undo u;
+        move_make(pos, list.moves[i], &u);
+        nodes += perft_hashed(pos, depth-1, t);
+        move_unmake(pos, list.moves[i], &u);
+    }
+
+    // siempre reemplaza: lo más reciente suele ser lo que se repite
+    data = (nodes << 8) | (uint64_t)depth;
+    pt_store(&e->data, data);
+    pt_store(&e->check, k ^ data);
+    return nodes;
+}
+
+/* ---------------- Instrumentación (CHESS_STATS) ---------------- */
+#ifdef CHESS_STATS
+__thread ChessStats gChessStats;
+#endif
+
+int chess_stats_take(ChessStats *out) {
+#ifdef CHESS_STATS
+    *out = gChessStats;
+    memset(&gChessStats, 0, sizeof(gChessStats));
+    return 1;
+#else
+    memset(out, 0, sizeof(*out));
+    return 0;
+#endif
+}
@@ -1,61 +1,218 @@
 #ifndef BOARD_H
 #define BOARD_H
 #include <stdint.h>
+#include <stddef.h>
 
-// Bitboards globales
-extern uint64_t WP, WN, WB, WR, WQ, WK;
-extern uint64_t BP, BN, BB, BR, BQ, BK;
+// Códigos de pieza (= índice en Position.bb)
+enum {
+    WP, WN, WB, WR, WQ, WK,
+    BP, BN, BB, BR, BQ, BK
+};
+
+// Posición completa: no hay estado global, se pueden tener varias a la vez
+typedef struct {
+    uint64_t bb[12];     // bitboards por código de pieza
+    int8_t mailbox[64];  // código de pieza por casilla (-1 vacía), en sincronía con bb
+    int side;            // 1 = mueven blancas, 0 = negras
+    int ep;              // casilla EP o -1
+    int castle;          // bitmask: 1=WK,2=WQ,4=BK,8=BQ
+    int halfmove;        // jugadas desde la última captura o peón (regla de 50)
+    int fullmove;        // nº de jugada, empieza en 1 y sube tras mover negras
+    uint64_t key;        // hash Zobrist (piezas, turno, enroques, columna EP)
+    // Caché de attacked_squares(): la llenan move_make (mapa del que movió),
+    // position_from_fen, board_init_startpos y position_refresh_attacks; las
+    // consultas const sólo la leen. Quien toque bb[] a mano debe llamar a
+    // position_refresh_attacks (o poner attacksValid = 0).
+    uint64_t attacks[2]; // casillas atacadas por negras [0] / blancas [1]
+    int attacksValid;    // bit 'side' puesto = attacks[side] al día
+} Position;
 
 // Utilidades básicas
 int      square_index(int file, int rank);
 uint64_t bit_at(int sq);
 
 // Ocupación
-uint64_t occ_white(void);
-uint64_t occ_black(void);
-uint64_t occ_all(void);
+uint64_t occ_white(const Position *pos);
+uint64_t occ_black(const Position *pos);
+uint64_t occ_all(const Position *pos);
 
 // Consultas
-int piece_code_at(int sq);  // 0..11 o -1 si vacío
-int is_white_at(int sq);    // 1 si blanca
-int is_black_at(int sq);    // 1 si negra
+int piece_code_at(const Position *pos, int sq);  // 0..11 o -1 si vacío
+int is_white_at(const Position *pos, int sq);    // 1 si blanca
+int is_black_at(const Position *pos, int sq);    // 1 si negra
 
 // ----- En passant (estado) -----
-int  get_ep_square(void);   // -1 si no hay EP
-void set_ep_square(int sq);
-void clear_ep_square(void);
+int  get_ep_square(const Position *pos);   // -1 si no hay EP
+void set_ep_square(Position *pos, int sq);
+void clear_ep_square(Position *pos);
 
 // ----- Derechos de enroque -----
-int  get_castle_rights(void);     // bitmask: 1=WK,2=WQ,4=BK,8=BQ
-void set_castle_rights(int rights);
-void clear_castle_rights(void);
+int  get_castle_rights(const Position *pos);     // bitmask: 1=WK,2=WQ,4=BK,8=BQ
+void set_castle_rights(Position *pos, int rights);
+void clear_castle_rights(Position *pos);
 
 // ----- Ataques precomputados / init -----
-void board_init_attacks(void);   // init tablas (caballo, rey)
+// Las tablas (caballo, rey, alfil, torre, Zobrist) se generan al compilar:
+// ya no hace falta llamarla, queda por compatibilidad.
+void board_init_attacks(void);
+
+// ----- Hash Zobrist -----
+// Recalcula desde cero; move_make/unmake mantienen pos->key incrementalmente.
+uint64_t position_compute_key(const Position *pos);
+
+// Todas las casillas atacadas por 'side' (1=blancas, 0=negras), con la
+// ocupación actual. Usa pos->attacks si está al día y si no lo calcula sin
+// escribir nada: una misma Position const se puede consultar desde varios hilos.
+uint64_t attacked_squares(const Position *pos, int side);
+
+// Calcula los dos mapas y los deja en la caché de pos.
+void position_refresh_attacks(Position *pos);
+
+// Los rayos de alfiles/torres/damas del mapa se rellenan con AVX2 si la CPU
+// lo tiene (se mira CPUID la primera vez) o por el camino escalar; los dos
+// dan exactamente el mismo mapa.
+const char *board_slider_kernel(void);   // "avx2" o "escalar"
+void        board_force_scalar(int on);  // 1: siempre escalar (llamar sin hilos buscando)
 
 // ¿Está atacada la casilla 'sq' por 'side' (1=blancas, 0=negras)?
-int is_square_attacked_by_side(int sq, int side);
+int is_square_attacked_by_side(const Position *pos, int sq, int side);
 
 // ¿Rey de 'side' en jaque?
-int is_king_in_check(int side);
+int is_king_in_check(const Position *pos, int side);
+
+// ----- Movimientos codificados en 16 bits -----
+// bits 0-5: origen | bits 6-11: destino | bits 12-15: flags
+typedef uint16_t Move;
+#define MOVE_NONE ((Move)0)
 
-// ----- Generación de movimientos -----
+enum {
+    MF_QUIET       = 0,
+    MF_DOUBLE_PUSH = 1,
+    MF_CASTLE_K    = 2,
+    MF_CASTLE_Q    = 3,
+    MF_CAPTURE     = 4,    // bit de captura
+    MF_EP          = 5,    // captura al paso
+    MF_PROMO       = 8,    // bit de promoción; bits 0-1: 0=N,1=B,2=R,3=Q
+    MF_PROMO_N = 8,  MF_PROMO_B = 9,  MF_PROMO_R = 10, MF_PROMO_Q = 11,
+    MF_PROMO_NC = 12, MF_PROMO_BC = 13, MF_PROMO_RC = 14, MF_PROMO_QC = 15
+};
+
+static inline Move move_encode(int fromSq, int toSq, int flags) {
+    return (Move)(fromSq | (toSq << 6) | (flags << 12));
+}
+static inline int move_from(Move m)       { return m & 63; }
+static inline int move_to(Move m)         { return (m >> 6) & 63; }
+static inline int move_flags(Move m)      { return m >> 12; }
+static inline int move_is_capture(Move m) { return (m >> 12) & MF_CAPTURE; }
+static inline int move_is_promo(Move m)   { return (m >> 12) & MF_PROMO; }
+static inline int move_is_castle(Move m)  { int f = m >> 12; return f == MF_CASTLE_K || f == MF_CASTLE_Q; }
+// Código de pieza promocionada para 'side' (1=blancas), o -1
+static inline int move_promo_code(Move m, int side) {
+    if (!move_is_promo(m)) return -1;
+    return (side == 1 ? WN : BN) + ((m >> 12) & 3);
+}
+
+// Lista de movimientos en el stack (218 es el máximo conocido)
+#define MAX_MOVES 256
+typedef struct {
+    Move moves[MAX_MOVES];
+    int  count;
+} MoveList;
+
+// ----- Generación de movimientos (para el bando que mueve) -----
 // Pseudolegales (incluye rey + enroques con chequeos básicos)
-uint64_t gen_moves_from(int sq, int sideToMove);
+uint64_t gen_moves_from(const Position *pos, int sq);
 
 // Legales = filtra pseudolegales que dejan al propio rey en jaque
-uint64_t gen_legal_moves_from(int sq, int sideToMove);
+uint64_t gen_legal_moves_from(const Position *pos, int sq);
+
+// Todos los movimientos legales de la posición (cada promoción por separado)
+void gen_legal_moves(const Position *pos, MoveList *list);
+
+// Busca el movimiento legal fromSq->toSq. promoteCode como en la GUI:
+// -1 = auto-dama | Blancas: 1=N,2=B,3=R,4=Q | Negras: 7=N,8=B,9=R,10=Q
+// Devuelve MOVE_NONE si no es legal.
+Move move_find(const Position *pos, int fromSq, int toSq, int promoteCode);
 
-// ----- Hacer movimiento (con promoción + EP + enroque) -----
-// promoteCode: -1 = auto-dama.
-// Blancas: 1=N,2=B,3=R,4=Q  |  Negras: 7=N,8=B,9=R,10=Q
-int move_make(int fromSq, int toSq, int sideToMove, int promoteCode);
+// ----- Hacer / deshacer movimiento (con promoción + EP + enroque) -----
+// Lo mínimo para deshacer: lo demás sale del Move y del mailbox.
+typedef struct {
+    int8_t captured;   // código capturado o -1
+    int8_t ep;         // casilla EP previa
+    int8_t castle;     // derechos de enroque previos
+    int16_t halfmove;  // contador de 50 jugadas previo
+    uint64_t key;      // hash previo (restaurarlo es más barato que deshacer XORs)
+} Undo;
+
+// Mueve el bando pos->side y le pasa el turno al rival.
+// 'u' puede ser NULL si no se va a deshacer.
+int  move_make(Position *pos, Move m, Undo *u);
+
+// Lo que hizo una jugada, armado por move_make_result mientras la aplica
+// (sin volver a mirar el tablero): para sonidos/animaciones, PGN, etc.
+typedef struct {
+    int8_t moved;        // código de la pieza que se movió
+    int8_t placed;       // código que quedó en el destino (= moved salvo promoción)
+    int8_t captured;     // código capturado o -1
+    int8_t capturedSq;   // casilla de la pieza capturada (en EP no es el destino) o -1
+    int8_t rookFrom;     // enroque: casillas de la torre, o -1
+    int8_t rookTo;
+    int8_t promo;        // código promocionado o -1
+    int8_t givesCheck;   // 1 si el rival quedó en jaque
+} MoveResult;
+
+// Igual que move_make y además llena 'res'. El jaque sale del mapa de
+// ataques del que movió, que queda en la caché para la generación del rival.
+int  move_make_result(Position *pos, Move m, Undo *u, MoveResult *res);
+// Revierte un move_make(pos, m, u) que devolvió 1.
+void move_unmake(Position *pos, Move m, const Undo *u);
+
+// Notación UCI ("e2e4", "e7e8q"); out necesita 6 bytes
+void move_to_uci(Move m, char out[6]);
 
 // ----- Perft (legal) -----
-uint64_t perft(int depth, int sideToMove);
-void perft_divide(int depth, int sideToMove);
+uint64_t perft(Position *pos, int depth);
+void perft_divide(Position *pos, int depth);
+
+// ----- Perft con tabla hash (para corridas profundas) -----
+// Guarda el conteo de subárboles por (hash, profundidad). Cada entrada se
+// escribe como key^data, así una entrada a medio escribir no valida.
+typedef struct {
+    uint64_t check;    // hash ^ data
+    uint64_t data;     // nodos << 8 | profundidad
+} PerftEntry;
+
+typedef struct {
+    PerftEntry *entries;
+    uint64_t    mask;      // nº de entradas - 1 (potencia de 2)
+    uint64_t    probes;    // consultas
+    uint64_t    hits;      // aciertos
+} PerftTable;
+
+// Reserva la mayor potencia de 2 de entradas que entra en 'megabytes'.
+// Devuelve 1 si pudo, 0 si no.
+int  perft_table_init(PerftTable *t, size_t megabytes);
+void perft_table_clear(PerftTable *t);
+void perft_table_free(PerftTable *t);
+// Mismos conteos que perft(); t == NULL equivale a perft().
+uint64_t perft_hashed(Position *pos, int depth, PerftTable *t);
 
 // Inicialización
-void board_init_startpos(void);
+void board_init_startpos(Position *pos);
+
+// ----- FEN -----
+// Longitud máxima de un FEN generado (con '\0')
+#define FEN_MAX 100
+
+// Carga un FEN completo (piezas, turno, enroques, EP, contadores) en una
+// pasada y sin reservar memoria. Los contadores son opcionales (0 y 1).
+// Rechaza FEN mal formados o imposibles: filas que no suman 8, un rey por
+// bando, peones en la 1ª/8ª, enroques sin rey/torre en su casilla, EP que no
+// sigue a un doble paso, o el bando que no mueve en jaque.
+// 1 = ok; 0 = error y 'pos' queda sin tocar.
+int position_from_fen(Position *pos, const char *fen);
+
+// Escribe el FEN de la posición en 'out' (FEN_MAX bytes). Devuelve la longitud.
+int position_to_fen(const Position *pos, char out[FEN_MAX]);
 
 #endif // BOARD_H
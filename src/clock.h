@@ -0,0 +1,16 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+#include <time.h>
+
+// Reloj monótono en segundos (para medir, no para fechas)
+static inline double clock_now(void) {
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+#endif // CLOCK_H
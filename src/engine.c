@@ -0,0 +1,191 @@
+#include "engine.h"
+#include "spsc.h"
+#include "stats.h"
+#include <pthread.h>
+#include <sched.h>
+
+typedef enum { CMD_SEARCH, CMD_STOP, CMD_QUIT } EngineCommandType;
+
+typedef struct {
+    EngineCommandType type;
+    uint32_t id;
+    Position pos;
+    int      maxDepth;
+    int      maxTimeMs;
+} EngineCommand;
+
+struct Engine {
+    pthread_t       thread;
+    SpscQueue       commands;   // GUI -> motor
+    SpscQueue       results;    // motor -> GUI
+    // Pedidos anunciados y todavía no tomados por el motor. La búsqueda lo usa
+    // como bandera de corte: si hay algo más nuevo, lo que se busca ya no sirve.
+    // La GUI lo sube ANTES de encolar, así nunca baja de 0 aunque el motor
+    // tome el pedido apenas entra (un -1 cortaría la búsqueda siguiente).
+    volatile int    pending;
+    uint32_t        nextId;     // sólo lo toca la GUI
+    TransTable      tt;
+    int             threads;
+    int             quitting;   // sólo lo toca el motor
+    // Sólo para dormir cuando no hay pedidos (la cola no usa el lock)
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+};
+
+/* ---------------- Lado del motor ---------------- */
+typedef struct {
+    Engine    *engine;
+    uint32_t   id;
+    ChessStats stats;    // acumulado del pedido (contadores de este hilo)
+} SearchJob;
+
+// Suma lo contado desde la última vez y lo pasa al resultado
+static void add_stats(SearchJob *job, EngineResult *r) {
+    ChessStats s;
+    chess_stats_take(&s);
+    job->stats.ttProbes += s.ttProbes;
+    job->stats.ttHits   += s.ttHits;
+    r->ttProbes = job->stats.ttProbes;
+    r->ttHits   = job->stats.ttHits;
+}
+
+static void fill_result(EngineResult *r, EngineResultType type, uint32_t id, const SearchInfo *info) {
+    r->type = type;
+    r->id = id;
+    r->depth = info->depth;
+    r->score = info->score;
+    r->nodes = info->nodes;
+    r->nps = info->nps;
+    r->pvLength = info->pvLength < ENGINE_PV_MAX ? info->pvLength : ENGINE_PV_MAX;
+    memcpy(r->pv, info->pv, sizeof(Move) * (size_t)r->pvLength);
+    r->best = r->pvLength > 0 ? r->pv[0] : MOVE_NONE;
+}
+
+// Cada iteración completa: si la GUI está atrasada y la cola está llena, se pierde
+static void on_iteration(const SearchInfo *info, void *user) {
+    SearchJob *job = (SearchJob*)user;
+    EngineResult r;
+    fill_result(&r, ENGINE_INFO, job->id, info);
+    add_stats(job, &r);
+    spsc_push(&job->engine->results, &r);
+}
+
+// Espera un pedido y devuelve el más nuevo de los encolados
+static EngineCommand next_command(Engine *e) {
+    EngineCommand cmd, newer;
+    pthread_mutex_lock(&e->lock);
+    while (!spsc_pop(&e->commands, &cmd)) pthread_cond_wait(&e->wake, &e->lock);
+    pthread_mutex_unlock(&e->lock);
+    int taken = 1;
+    while (spsc_pop(&e->commands, &newer)) {
+        if (cmd.type == CMD_QUIT) e->quitting = 1; // un QUIT nunca se pierde
+        cmd = newer;
+        taken++;
+    }
+    __atomic_sub_fetch(&e->pending, taken, __ATOMIC_ACQ_REL);
+    if (e->quitting) cmd.type = CMD_QUIT;
+    return cmd;
+}
+
+static void *engine_main(void *arg) {
+    Engine *e = (Engine*)arg;
+    for (;;) {
+        EngineCommand cmd = next_command(e);
+        if (cmd.type == CMD_QUIT) break;
+        if (cmd.type != CMD_SEARCH) continue;
+
+        SearchJob job = { e, cmd.id, { 0 } };
+        ChessStats stale;
+        chess_stats_take(&stale); // descartar lo contado antes de este pedido
+        SearchLimits lim = { 0 };
+        lim.maxDepth = cmd.maxDepth;
+        lim.maxTimeMs = cmd.maxTimeMs;
+        lim.stop = &e->pending;
+        lim.tt = e->tt.entries ? &e->tt : NULL;
+        lim.threads = e->threads;
+        lim.onIteration = on_iteration;
+        lim.user = &job;
+
+        SearchInfo info;
+        Move best = search_best_move(&cmd.pos, &lim, &info);
+
+        EngineResult r;
+        fill_result(&r, ENGINE_BESTMOVE, cmd.id, &info);
+        add_stats(&job, &r);
+        r.best = best;
+        // el resultado final no se puede perder: esperar lugar (la GUI lee cada frame)
+        while (!spsc_push(&e->results, &r)) {
+            if (__atomic_load_n(&e->pending, __ATOMIC_ACQUIRE)) break; // ya hay otro pedido
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* ---------------- Lado de la GUI ---------------- */
+static void post(Engine *e, const EngineCommand *cmd) {
+    __atomic_add_fetch(&e->pending, 1, __ATOMIC_ACQ_REL);
+    while (!spsc_push(&e->commands, cmd)) sched_yield(); // 16 lugares: no pasa en la práctica
+    pthread_mutex_lock(&e->lock);
+    pthread_cond_signal(&e->wake);
+    pthread_mutex_unlock(&e->lock);
+}
+
+Engine *engine_start(size_t hashMB, int threads) {
+    Engine *e = (Engine*)calloc(1, sizeof(Engine));
+    if (!e) return NULL;
+    if (!spsc_init(&e->commands, sizeof(EngineCommand), 16) ||
+        !spsc_init(&e->results, sizeof(EngineResult), 256)) {
+        spsc_free(&e->commands); spsc_free(&e->results); free(e);
+        return NULL;
+    }
+    if (hashMB > 0 && !tt_init(&e->tt, hashMB, 0)) memset(&e->tt, 0, sizeof(e->tt)); // sin TT igual anda
+    e->threads = threads;
+    pthread_mutex_init(&e->lock, NULL);
+    pthread_cond_init(&e->wake, NULL);
+    if (pthread_create(&e->thread, NULL, engine_main, e) != 0) {
+        pthread_mutex_destroy(&e->lock); pthread_cond_destroy(&e->wake);
+        if (e->tt.entries) tt_free(&e->tt);
+        spsc_free(&e->commands); spsc_free(&e->results); free(e);
+        return NULL;
+    }
+    return e;
+}
+
+uint32_t engine_search(Engine *e, const Position *pos, int maxDepth, int maxTimeMs) {
+    EngineCommand cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SEARCH;
+    cmd.id = ++e->nextId;
+    cmd.pos = *pos;
+    cmd.maxDepth = maxDepth;
+    cmd.maxTimeMs = maxTimeMs;
+    post(e, &cmd);
+    return cmd.id;
+}
+
+void engine_stop(Engine *e) {
+    EngineCommand cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_STOP;
+    post(e, &cmd);
+}
+
+int engine_poll(Engine *e, EngineResult *out) {
+    return spsc_pop(&e->results, out);
+}
+
+void engine_quit(Engine *e) {
+    if (!e) return;
+    EngineCommand cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_QUIT;
+    post(e, &cmd);
+    pthread_join(e->thread, NULL);
+    pthread_mutex_destroy(&e->lock);
+    pthread_cond_destroy(&e->wake);
+    if (e->tt.entries) tt_free(&e->tt);
+    spsc_free(&e->commands);
+    spsc_free(&e->results);
+    free(e);
+}
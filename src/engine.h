@@ -0,0 +1,47 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+#include "board.h"
+#include "search.h"
+
+// ----- Motor en un hilo aparte -----
+// La GUI le manda pedidos por una cola SPSC y levanta resultados por otra,
+// también SPSC, una vez por frame: ninguna de las dos partes espera a la otra.
+// Un pedido nuevo corta la búsqueda en curso; los resultados llevan el id
+// del pedido para que la GUI descarte los viejos.
+
+#define ENGINE_PV_MAX 16
+
+typedef enum {
+    ENGINE_INFO,       // iteración completa (análisis)
+    ENGINE_BESTMOVE    // fin de la búsqueda de un pedido
+} EngineResultType;
+
+typedef struct {
+    EngineResultType type;
+    uint32_t id;           // el que devolvió engine_search
+    int      depth;
+    int      score;        // desde el bando que mueve en la posición pedida
+    uint64_t nodes;
+    uint64_t nps;
+    Move     best;
+    Move     pv[ENGINE_PV_MAX];
+    int      pvLength;
+    uint64_t ttProbes;     // con CHESS_STATS: consultas a la TT del hilo principal
+    uint64_t ttHits;       //   de la búsqueda y aciertos (0 sin CHESS_STATS)
+} EngineResult;
+
+typedef struct Engine Engine;
+
+// Arranca el hilo del motor con su propia TT. NULL si no pudo.
+Engine  *engine_start(size_t hashMB, int threads);
+// Pide buscar 'pos' (se copia). maxDepth/maxTimeMs = 0: sin límite (análisis
+// hasta engine_stop u otro pedido). Devuelve el id del pedido.
+uint32_t engine_search(Engine *e, const Position *pos, int maxDepth, int maxTimeMs);
+// Corta la búsqueda en curso (igual llega su ENGINE_BESTMOVE)
+void     engine_stop(Engine *e);
+// Saca un resultado si hay; 0 si no (nunca espera)
+int      engine_poll(Engine *e, EngineResult *out);
+// Corta, espera al hilo y libera todo
+void     engine_quit(Engine *e);
+
+#endif // ENGINE_H
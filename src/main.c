@@ -2,7 +2,11 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include "board.h"
+#include "engine.h"
+#include "stats.h"
+#include "clock.h"
 
 #define BOARD 8
 
@@ -12,7 +16,10 @@ typedef enum {
     TEX_BP, TEX_BN, TEX_BB, TEX_BR, TEX_BQ, TEX_BK,
     TEX_COUNT
 } PieceTex;
-static Texture2D gPieceTex[TEX_COUNT];
+// Las 12 piezas van en un solo atlas armado al cargar: todas se dibujan desde
+// la misma textura y raylib las junta en un único batch (sin cambiar textura).
+static Texture2D gPieceAtlas;
+static Rectangle gPieceSrc[TEX_COUNT];   // recorte de cada pieza en el atlas
 
 // --- Sonidos ---
 static Sound sndMove;
@@ -46,13 +53,52 @@ static void draw_board(int SQ, Color light, Color dark) {
         }
 }
 
+// Las casillas se dibujan una vez en una RenderTexture y cada frame se copia
+// entera; sólo se rehace cuando la ventana cambia de tamaño (cambia SQ).
+static RenderTexture2D gBoardLayer;
+static int gBoardLayerSQ = 0;
+
+static void board_layer_update(int SQ, Color light, Color dark) {
+    if (gBoardLayer.id && gBoardLayerSQ == SQ) return;
+    if (gBoardLayer.id) UnloadRenderTexture(gBoardLayer);
+    gBoardLayer = LoadRenderTexture(SQ * BOARD, SQ * BOARD);
+    gBoardLayerSQ = SQ;
+    BeginTextureMode(gBoardLayer);
+    draw_board(SQ, light, dark);
+    EndTextureMode();
+}
+
+static void draw_board_layer(void) {
+    Texture2D t = gBoardLayer.texture;
+    // en OpenGL la RenderTexture queda invertida: alto negativo la endereza
+    DrawTextureRec(t, (Rectangle){0, 0, (float)t.width, -(float)t.height}, (Vector2){0, 0}, WHITE);
+}
+
 // ---------- Debug overlay ----------
 static bool gShowDebug = false;
 static const Color DBG_BG = {30,30,50,180};
 static const Color DBG_FG = {220,230,255,255};
 
+// Con CHESS_STATS el overlay suma los contadores de board.c y el tiempo que la
+// GUI pasa en chequeos de legalidad; sin la opción estas macros no hacen nada.
+#ifdef CHESS_STATS
+static double     gLegalSecs = 0.0;        // frame en curso
+static double     gFrameLegalMs = 0.0;     // frame anterior
+static double     gFrameWorkMs = 0.0;      // frame anterior: update + dibujo, sin esperas
+static ChessStats gFrameStats;             // frame anterior
+#define LEGAL_TIMER_START() double legalT0 = clock_now()
+#define LEGAL_TIMER_STOP()  (gLegalSecs += clock_now() - legalT0)
+#else
+#define LEGAL_TIMER_START() ((void)0)
+#define LEGAL_TIMER_STOP()  ((void)0)
+#endif
+
+// ---------- Posición ----------
+static Position gPos;          // única instancia del tablero de la partida
+
 // ---------- Selección / turno ----------
 static int gSelectedSq = -1;   // -1 = nada seleccionado
+static uint64_t gMoveTargets = 0ULL; // destinos legales de gSelectedSq
 static int gSideToMove = 1;    // 1 blancas, 0 negras
 
 // ---------- Game Over ----------
@@ -60,34 +106,68 @@ static bool gGameOver = false;
 static char gGameOverMsg[64] = "";
 
 // ---------- Carga de sprites ----------
+// Cada PNG va a una celda de una grilla 6x2 con ATLAS_PAD píxeles
+// transparentes alrededor, para que el filtro bilineal no mezcle vecinas.
+#define ATLAS_PAD 2
+
 static bool load_piece_textures(const char *baseDir) {
+    static const char *FILES[TEX_COUNT] = {
+        "wP.png", "wN.png", "wB.png", "wR.png", "wQ.png", "wK.png",
+        "bP.png", "bN.png", "bB.png", "bR.png", "bQ.png", "bK.png",
+    };
     char path[256];
-    #define LOAD(slot, filename) do { \
-        snprintf(path, sizeof(path), "%s/%s", baseDir, filename); \
-        gPieceTex[slot] = LoadTexture(path); \
-        if (gPieceTex[slot].id == 0) { TraceLog(LOG_ERROR, "No pude cargar %s", path); return false; } \
-        SetTextureFilter(gPieceTex[slot], TEXTURE_FILTER_BILINEAR); \
-    } while (0)
-
-    LOAD(TEX_WP,"wP.png"); LOAD(TEX_WN,"wN.png"); LOAD(TEX_WB,"wB.png");
-    LOAD(TEX_WR,"wR.png"); LOAD(TEX_WQ,"wQ.png"); LOAD(TEX_WK,"wK.png");
-    LOAD(TEX_BP,"bP.png"); LOAD(TEX_BN,"bN.png"); LOAD(TEX_BB,"bB.png");
-    LOAD(TEX_BR,"bR.png"); LOAD(TEX_BQ,"bQ.png"); LOAD(TEX_BK,"bK.png");
-    #undef LOAD
+    Image img[TEX_COUNT];
+    int cellW = 0, cellH = 0;
+    for (int i = 0; i < TEX_COUNT; ++i) {
+        snprintf(path, sizeof(path), "%s/%s", baseDir, FILES[i]);
+        img[i] = LoadImage(path);
+        if (img[i].data == NULL) {
+            TraceLog(LOG_ERROR, "No pude cargar %s", path);
+            while (i--) UnloadImage(img[i]);
+            return false;
+        }
+        if (img[i].width > cellW)  cellW = img[i].width;
+        if (img[i].height > cellH) cellH = img[i].height;
+    }
+
+    cellW += 2 * ATLAS_PAD;
+    cellH += 2 * ATLAS_PAD;
+    Image atlas = GenImageColor(6 * cellW, 2 * cellH, BLANK);
+    for (int i = 0; i < TEX_COUNT; ++i) {
+        Rectangle src = { 0, 0, (float)img[i].width, (float)img[i].height };
+        Rectangle dst = { (float)((i % 6) * cellW + ATLAS_PAD), (float)((i / 6) * cellH + ATLAS_PAD),
+                          src.width, src.height };
+        ImageDraw(&atlas, img[i], src, dst, WHITE);
+        gPieceSrc[i] = dst;
+        UnloadImage(img[i]);
+    }
+    gPieceAtlas = LoadTextureFromImage(atlas);
+    UnloadImage(atlas);
+    if (gPieceAtlas.id == 0) { TraceLog(LOG_ERROR, "No pude crear el atlas de piezas"); return false; }
+    SetTextureFilter(gPieceAtlas, TEXTURE_FILTER_BILINEAR);
     return true;
 }
 static void unload_piece_textures(void) {
-    for (int i = 0; i < TEX_COUNT; ++i) if (gPieceTex[i].id) UnloadTexture(gPieceTex[i]);
+    if (gPieceAtlas.id) UnloadTexture(gPieceAtlas);
+    if (gBoardLayer.id) UnloadRenderTexture(gBoardLayer);
+}
+
+// Pieza 'idx' centrada en 'box', ocupando 'fill' del lado menor
+static void draw_piece(int idx, Rectangle box, float fill) {
+    Rectangle src = gPieceSrc[idx];
+    float boxSide = box.width < box.height ? box.width : box.height;
+    float scale = fill * boxSide / (src.width > src.height ? src.width : src.height);
+    float w = src.width * scale, h = src.height * scale;
+    Rectangle dst = { box.x + (box.width - w) * 0.5f, box.y + (box.height - h) * 0.5f, w, h };
+    // medio píxel adentro: el bilineal no toma el borde transparente de la celda
+    src = (Rectangle){ src.x + 0.5f, src.y + 0.5f, src.width - 1.0f, src.height - 1.0f };
+    DrawTexturePro(gPieceAtlas, src, dst, (Vector2){0, 0}, 0.0f, WHITE);
 }
 
 // ---------- Mapear casilla -> índice de textura ----------
+// Las texturas siguen el orden de los códigos de pieza (TEX_WP == WP, ...)
 static int piece_index_at_tex(int sq) {
-    uint64_t m = bit_at(sq);
-    if (WP & m) return TEX_WP; if (WN & m) return TEX_WN; if (WB & m) return TEX_WB;
-    if (WR & m) return TEX_WR; if (WQ & m) return TEX_WQ; if (WK & m) return TEX_WK;
-    if (BP & m) return TEX_BP; if (BN & m) return TEX_BN; if (BB & m) return TEX_BB;
-    if (BR & m) return TEX_BR; if (BQ & m) return TEX_BQ; if (BK & m) return TEX_BK;
-    return -1;
+    return piece_code_at(&gPos, sq);
 }
 
 // ---------- Animación de movimientos ----------
@@ -115,26 +195,29 @@ static float easeInOutCubic(float t) {
 }
 
 // ---------- Dibujar piezas con proporción (omite destino si hay animación) ----------
+// Recorre sólo las casillas ocupadas; todas salen del atlas en un batch.
 static void draw_pieces_textured(int SQ) {
-    const float scalePad = 0.90f; // 90% de la casilla
-    for (int sq = 0; sq < 64; ++sq) {
+    for (uint64_t occ = occ_all(&gPos); occ; occ &= occ - 1) {
+        int sq = __builtin_ctzll(occ);
         if ((gAnim.active && sq == gAnim.toSq) || (gAnimR.active && sq == gAnimR.toSq)) continue; // evitar duplicado
 
-        int idx = piece_index_at_tex(sq);
-        if (idx < 0) continue;
-
-        int file = sq % 8, rank = sq / 8, x, y;
-        square_to_xy(file, rank, SQ, &x, &y);
-
-        Texture2D tex = gPieceTex[idx];
-        float scale = scalePad * (float)SQ / (float)((tex.width > tex.height) ? tex.width : tex.height);
-        float w = tex.width * scale, h = tex.height * scale;
-        Rectangle src = (Rectangle){0.5f,0.5f,(float)tex.width - 1.0f,(float)tex.height - 1.0f};
-        Rectangle dst = (Rectangle){ x + (SQ - w)*0.5f, y + (SQ - h)*0.5f, w, h };
-        DrawTexturePro(tex, src, dst, (Vector2){0,0}, 0.0f, WHITE);
+        int x, y;
+        square_to_xy(sq % 8, sq / 8, SQ, &x, &y);
+        draw_piece(piece_index_at_tex(sq), (Rectangle){ (float)x, (float)y, (float)SQ, (float)SQ }, 0.90f);
     }
 }
 
+// Pieza en vuelo de una animación (interpolada entre origen y destino)
+static void draw_anim(const MoveAnim *a, int SQ) {
+    if (!a->active || a->texIdx < 0) return;
+    int x0, y0, x1, y1;
+    square_to_xy(a->fromSq % 8, a->fromSq / 8, SQ, &x0, &y0);
+    square_to_xy(a->toSq % 8, a->toSq / 8, SQ, &x1, &y1);
+    float t = easeInOutCubic(a->t);
+    Rectangle box = { x0 + (x1 - x0) * t, y0 + (y1 - y0) * t, (float)SQ, (float)SQ };
+    draw_piece(a->texIdx, box, 0.90f);
+}
+
 // ---------- Promoción: UI ----------
 typedef struct {
     bool active;
@@ -144,12 +227,6 @@ typedef struct {
 
 static PromotionUI gPromo = (PromotionUI){ false, -1, -1, 1 };
 
-// ¿el movimiento desde->hacia sería una promoción?
-static inline bool would_promote(int fromSq, int toSq, int side) {
-    int code = piece_code_at(fromSq); // 0=WP, 6=BP
-    int toRank = toSq / 8;
-    return (side==1 && code==0 && toRank==7) || (side==0 && code==6 && toRank==0);
-}
 
 // Mapeos de código de promoción para move_make()
 static inline int promo_code_from_char(int side, char c) {
@@ -187,15 +264,7 @@ static int draw_and_pick_promotion(int SQ) {
         DrawRectangleLinesEx(rects[i], 2, (Color){180,180,220,220});
 
         int texIdx = promo_texture_index(gPromo.side, opts[i]);
-        if (texIdx >= 0) {
-            Texture2D t = gPieceTex[texIdx];
-            float maxSide = (rects[i].width < rects[i].height ? rects[i].width : rects[i].height) * 0.8f;
-            float scale = maxSide / (float)((t.width > t.height) ? t.width : t.height);
-            float w = t.width * scale, h = t.height * scale;
-            float dx = rects[i].x + (rects[i].width - w)/2.0f;
-            float dy = rects[i].y + (rects[i].height - h)/2.0f;
-            DrawTexturePro(t, (Rectangle){0,0,(float)t.width,(float)t.height}, (Rectangle){dx,dy,w,h}, (Vector2){0,0}, 0, WHITE);
-        }
+        if (texIdx >= 0) draw_piece(texIdx, rects[i], 0.8f);
         DrawText((const char[]){opts[i],0}, (int)(rects[i].x + rects[i].width/2 - 6),
                  (int)(rects[i].y + rects[i].height - 18), 18, (Color){230,230,255,255});
     }
@@ -211,17 +280,55 @@ static int draw_and_pick_promotion(int SQ) {
     return -1;
 }
 
+// Última jugada aplicada: su jaque da el sonido al cambiar el turno
+static MoveResult gLastMove;
+
+// ---------- Jugadas legales del turno ----------
+// Se generan una sola vez cuando cambia el turno. Selección, destinos,
+// promoción, fin de partida y el resaltado del jaque leen de acá: en un
+// frame normal no se hace ningún chequeo de legalidad.
+typedef struct {
+    MoveList list;          // todas las jugadas legales (cada promoción por separado)
+    uint64_t targets[64];   // destinos legales por casilla de origen
+    uint64_t promoFrom;     // orígenes cuyas jugadas son promociones
+    int      kingSq;        // rey del bando que mueve
+    bool     inCheck;
+} TurnMoves;
+
+static TurnMoves gTurn;
+
+static void turn_moves_refresh(void) {
+    LEGAL_TIMER_START();
+    gen_legal_moves(&gPos, &gTurn.list);
+    memset(gTurn.targets, 0, sizeof(gTurn.targets));
+    gTurn.promoFrom = 0ULL;
+    for (int i = 0; i < gTurn.list.count; ++i) {
+        Move m = gTurn.list.moves[i];
+        gTurn.targets[move_from(m)] |= bit_at(move_to(m));
+        if (move_is_promo(m)) gTurn.promoFrom |= bit_at(move_from(m));
+    }
+    uint64_t king = gPos.bb[gPos.side == 1 ? WK : BK];
+    gTurn.kingSq = king ? __builtin_ctzll(king) : -1;
+    // tras move_make_result el mapa de ataques del rival ya está en la caché
+    gTurn.inCheck = is_king_in_check(&gPos, gPos.side);
+    LEGAL_TIMER_STOP();
+}
+
+// La jugada legal desde->hacia de la lista del turno (promoCode como en move_find)
+static Move turn_find_move(int fromSq, int toSq, int promoCode) {
+    int promo = promoCode == -1 ? (gPos.side == 1 ? WQ : BQ) : promoCode;
+    for (int i = 0; i < gTurn.list.count; ++i) {
+        Move m = gTurn.list.moves[i];
+        if (move_from(m) != fromSq || move_to(m) != toSq) continue;
+        if (!move_is_promo(m) || move_promo_code(m, gPos.side) == promo) return m;
+    }
+    return MOVE_NONE;
+}
+
 // ---------- Helpers: chequeo fin de partida ----------
 static void check_game_over_after_turn_change(void) {
-    bool noMoves = true;
-    for (int sq = 0; sq < 64; ++sq) {
-        if ((gSideToMove==1 && is_white_at(sq)) || (gSideToMove==0 && is_black_at(sq))) {
-            uint64_t moves = gen_legal_moves_from(sq, gSideToMove);
-            if (moves) { noMoves = false; break; }
-        }
-    }
-    if (noMoves) {
-        if (is_king_in_check(gSideToMove)) {
+    if (gTurn.list.count == 0) {
+        if (gTurn.inCheck) {
             snprintf(gGameOverMsg, sizeof(gGameOverMsg), "Jaque mate! %s gana",
                      gSideToMove ? "Negras" : "Blancas");
         } else {
@@ -231,15 +338,205 @@ static void check_game_over_after_turn_change(void) {
     }
 }
 
-static uint64_t gMoveTargets = 0ULL;
+// ---------- Jugar un movimiento (click o motor): sonido + animación ----------
+// move_make_result dice qué pasó (captura, EP, enroque, jaque): no hace falta
+// mirar el tablero antes de mover.
+// El turno cambia cuando terminan las animaciones (gPendingTurnSwitch).
+static bool play_move_animated(int fromSq, int toSq) {
+    MoveResult res;
+    if (!move_make_result(&gPos, turn_find_move(fromSq, toSq, -1), NULL, &res)) return false;
+    gLastMove = res;
+
+    bool isCastle = res.rookFrom != -1;
+    if (isCastle) {
+        PlaySound(sndCastle);
+    } else if (res.captured != -1) { // incluye EP
+        PlaySound(sndCapture);
+    } else {
+        PlaySound(sndMove);
+    }
+
+    // Animación de la pieza (las texturas siguen el orden de los códigos)
+    gAnim = (MoveAnim){ true, fromSq, toSq, res.moved, 0.0f, 0.18f };
+
+    // Si fue enroque, también animamos la TORRE
+    if (isCastle) {
+        int rookTex = res.moved == WK ? TEX_WR : TEX_BR;
+        gAnimR = (MoveAnim){ true, res.rookFrom, res.rookTo, rookTex, 0.0f, 0.18f };
+    } else {
+        gAnimR.active = false;
+    }
+
+    // Cambiar turno al finalizar TODAS las animaciones
+    gPendingTurnSwitch = true;
+    return true;
+}
+
+// ---------- Cambio de turno: fin de partida, jaque y motor ----------
+static void engine_on_position_changed(void);
+
+static void switch_turn(void) {
+    gSideToMove = 1 - gSideToMove;
+    gSelectedSq = -1;              // la selección era del bando anterior
+    gMoveTargets = 0ULL;
+    turn_moves_refresh();
+    check_game_over_after_turn_change();
+
+    // Sonido de jaque (al comenzar el turno en jaque)
+    if (!gGameOver && gLastMove.givesCheck) {
+        PlaySound(sndCheck);
+    }
+    engine_on_position_changed();
+}
+
+// Promoción: sin animación, el turno cambia enseguida
+static bool play_promotion(int fromSq, int toSq, int promoCode) {
+    if (!move_make_result(&gPos, turn_find_move(fromSq, toSq, promoCode), NULL, &gLastMove)) return false;
+    PlaySound(sndPromo);
+    switch_turn();
+    return true;
+}
+
+// ---------- Motor (hilo aparte) ----------
+// El frame sólo encola pedidos y levanta resultados: nunca espera al motor.
+#define ENGINE_MOVE_MS 1000            // tiempo por jugada cuando juega el motor
+
+static Engine      *gEngine = NULL;
+static bool         gAnalysis = false;        // F4: analizar la posición actual
+static int          gEngineSide = -1;         // F5: bando del motor (-1 ninguno, 0 negras, 1 blancas)
+static uint32_t     gEngineReq = 0;           // pedido vigente (0 = ninguno)
+static bool         gEngineReqIsMove = false; // el pedido vigente es "jugá"
+static EngineResult gEngineInfo;              // última iteración del pedido vigente
+static bool         gEngineHasInfo = false;
+
+static void engine_on_position_changed(void) {
+    if (!gEngine) return;
+    gEngineHasInfo = false;
+    gEngineReqIsMove = false;
+    if (!gGameOver && gSideToMove == gEngineSide) {
+        gSelectedSq = -1;          // F5: el motor toma el bando que tenía algo seleccionado
+        gMoveTargets = 0ULL;
+        gEngineReq = engine_search(gEngine, &gPos, 0, ENGINE_MOVE_MS);
+        gEngineReqIsMove = true;
+    } else if (!gGameOver && gAnalysis) {
+        gEngineReq = engine_search(gEngine, &gPos, 0, 0);
+    } else if (gEngineReq) {
+        engine_stop(gEngine);
+        gEngineReq = 0;
+    }
+}
+
+// Devuelve true si llegó algo del pedido vigente (hay que redibujar)
+static bool engine_poll_results(void) {
+    EngineResult r;
+    bool changed = false;
+    while (gEngine && engine_poll(gEngine, &r)) {
+        if (r.id != gEngineReq) continue; // de un pedido viejo
+        changed = true;
+        if (r.depth > 0) { gEngineInfo = r; gEngineHasInfo = true; }
+
+        if (r.type != ENGINE_BESTMOVE) continue;
+        // el pedido terminó (también un análisis que llegó a mate o a la
+        // profundidad máxima): sin esto el bucle seguiría despierto a 60 Hz
+        bool play = gEngineReqIsMove;
+        gEngineReq = 0;
+        gEngineReqIsMove = false;
+        if (play && r.best != MOVE_NONE) {
+            int from = move_from(r.best), to = move_to(r.best);
+            if (move_is_promo(r.best)) play_promotion(from, to, move_promo_code(r.best, gSideToMove));
+            else play_move_animated(from, to);
+        }
+    }
+    return changed;
+}
+
+// Barra inferior + mejor jugada resaltada
+static void draw_engine_panel(int SQ) {
+    if (!gEngine || (!gAnalysis && gEngineSide == -1) || gGameOver) return;
+    const int W = GetScreenWidth(), H = GetScreenHeight();
+
+    if (gEngineHasInfo && gEngineInfo.best != MOVE_NONE && !gPendingTurnSwitch) {
+        int sqs[2] = { move_from(gEngineInfo.best), move_to(gEngineInfo.best) };
+        for (int i = 0; i < 2; ++i) {
+            int x, y; square_to_xy(sqs[i] % 8, sqs[i] / 8, SQ, &x, &y);
+            DrawRectangle(x, y, SQ, SQ, (Color){60,110,255,70});
+        }
+    }
+
+    const char *who = gEngineReqIsMove ? "Motor pensando" : "Análisis";
+    DrawRectangle(0, H - 26, W, 26, DBG_BG);
+    if (!gEngineHasInfo) {
+        DrawText(TextFormat("%s...", who), 8, H - 21, 16, DBG_FG);
+        return;
+    }
+
+    // puntaje desde blancas
+    int score = gSideToMove == 1 ? gEngineInfo.score : -gEngineInfo.score;
+    const char *scoreTxt = score_is_mate(score) ? TextFormat("#%d", score_mate_in(score))
+                                                : TextFormat("%+.2f", score / 100.0);
+    char pv[64] = "";
+    for (int i = 0, len = 0; i < gEngineInfo.pvLength && i < 6; ++i) {
+        char uci[6]; move_to_uci(gEngineInfo.pv[i], uci);
+        len += snprintf(pv + len, sizeof(pv) - (size_t)len, "%s%s", i ? " " : "", uci);
+        if (len >= (int)sizeof(pv)) break;
+    }
+    DrawText(TextFormat("%s  prof %d  %s  %.2f Mnps  %s", who, gEngineInfo.depth, scoreTxt,
+                        gEngineInfo.nps / 1e6, pv), 8, H - 21, 16, DBG_FG);
+}
+
+// F3: casilla, turno, jaque y (con CHESS_STATS) contadores del frame anterior
+static void draw_debug_overlay(int f, int r) {
+#ifdef CHESS_STATS
+    DrawRectangle(12, 12, 400, 186, DBG_BG);
+#else
+    DrawRectangle(12, 12, 150, 80, DBG_BG);
+#endif
+    if (f!=-1) DrawText(TextFormat("file=%d  rank=%d", f+1, r+1), 20, 18, 20, DBG_FG);
+    DrawText(gSideToMove ? "Turno: Blancas" : "Turno: Negras", 20, 40, 18, DBG_FG);
+    DrawText(gTurn.inCheck && !gPendingTurnSwitch ? "¡Jaque!" : "", 20, 58, 18, RED);
+    DrawText(gGameOver ? "GAME OVER" : "", 20, 72, 18, ORANGE);
+#ifdef CHESS_STATS
+    const ChessStats *s = &gFrameStats;
+    DrawText(TextFormat("frame %.2f ms  legalidad %.3f ms", gFrameWorkMs, gFrameLegalMs),
+             20, 96, 16, DBG_FG);
+    DrawText(TextFormat("move_make %llu  legales %llu  desde casilla %llu", (unsigned long long)s->makes,
+                        (unsigned long long)s->legalGens, (unsigned long long)s->legalFrom), 20, 116, 16, DBG_FG);
+    DrawText(TextFormat("ataques: consultas %llu  mapas %llu", (unsigned long long)s->attackQueries,
+                        (unsigned long long)s->attackMaps), 20, 136, 16, DBG_FG);
+    DrawText(TextFormat("lecturas de deslizantes %llu", (unsigned long long)s->sliderLookups), 20, 156, 16, DBG_FG);
+    if (gEngineHasInfo) {
+        double hit = gEngineInfo.ttProbes ? 100.0 * (double)gEngineInfo.ttHits / (double)gEngineInfo.ttProbes : 0.0;
+        DrawText(TextFormat("motor %.2f Mnps  TT %.1f%% aciertos", gEngineInfo.nps / 1e6, hit), 20, 176, 16, DBG_FG);
+    } else {
+        DrawText("motor: sin datos", 20, 176, 16, DBG_FG);
+    }
+#endif
+}
+
+// ---------- Redibujado por eventos ----------
+// Con algo en curso (animación, motor pensando, overlay F3) el loop sigue a
+// ~60 vueltas por segundo; si no, raylib duerme hasta el próximo evento de
+// input y el proceso no gasta CPU. Llamar justo antes de EndDrawing /
+// PollInputEvents, que es donde se espera.
+static void update_event_waiting(void) {
+    static bool waiting = false;
+    bool busy = gAnim.active || gAnimR.active || gPendingTurnSwitch || gEngineReq != 0 || gShowDebug;
+    if (busy == waiting) {
+        if (busy) DisableEventWaiting();
+        else      EnableEventWaiting();
+        waiting = !busy;
+    }
+}
 
 int main(void) {
     const int W = 720, H = 720;
-    const int SQ = W / BOARD;
+    int SQ = W / BOARD;
     const Color COL_LIGHT = (Color){240,217,181,255};
     const Color COL_DARK  = (Color){181,136, 99,255};
 
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(W, H, "Chess (C + raylib)");
+    SetWindowMinSize(BOARD * 40, BOARD * 40);
     SetExitKey(KEY_NULL); // controlamos ESC nosotros
 
     InitAudioDevice();
@@ -265,14 +562,53 @@ int main(void) {
     if (!load_piece_textures("assets")) { CloseAudioDevice(); CloseWindow(); return 1; }
     SetTargetFPS(60);
 
-    board_init_startpos();
+    board_init_startpos(&gPos);
+    turn_moves_refresh();
+    gEngine = engine_start(32, 1);
+    if (!gEngine) TraceLog(LOG_WARNING, "No pude arrancar el motor");
 
     bool running = true;
+    bool dirty = true;            // hay que dibujar en esta vuelta
+    int lastHoverSq = -1;
+    double lastTime = GetTime();
     while (running && !WindowShouldClose()) {
+        // Paso de las animaciones con reloj propio: GetFrameTime sólo avanza
+        // en las vueltas que dibujan, y tras dormir sería enorme
+        double now = GetTime();
+        float dt = (float)(now - lastTime);
+        lastTime = now;
+        if (dt > 1.0f / 30.0f) dt = 1.0f / 30.0f;
+
+#ifdef CHESS_STATS
+        // lo contado en el frame anterior queda fijo para el overlay
+        chess_stats_take(&gFrameStats);
+        gFrameLegalMs = gLegalSecs * 1000.0;
+        gLegalSecs = 0.0;
+#endif
+
+        // El tablero ocupa el lado menor de la ventana
+        int screenSide = GetScreenWidth() < GetScreenHeight() ? GetScreenWidth() : GetScreenHeight();
+        SQ = screenSide / BOARD;
+        board_layer_update(SQ, COL_LIGHT, COL_DARK);
 
         // --------- INPUT ---------
+        // Teclas que cambian algo en pantalla (Q/R/B/N las lee el modal al dibujarse)
+        if (IsWindowResized() || IsKeyPressed(KEY_F3) || IsKeyPressed(KEY_F4) || IsKeyPressed(KEY_F5) ||
+            IsKeyPressed(KEY_ESCAPE) || IsMouseButtonPressed(MOUSE_LEFT_BUTTON) ||
+            IsMouseButtonPressed(MOUSE_RIGHT_BUTTON))
+            dirty = true;
+        if (gPromo.active && (IsKeyPressed(KEY_Q) || IsKeyPressed(KEY_R) || IsKeyPressed(KEY_B) || IsKeyPressed(KEY_N)))
+            dirty = true;
+
         if (IsKeyPressed(KEY_F3)) gShowDebug = !gShowDebug;
 
+        // F4: análisis on/off | F5: el motor juega con negras -> blancas -> nadie
+        bool engineToggled = false;
+        if (IsKeyPressed(KEY_F4)) { gAnalysis = !gAnalysis; engineToggled = true; }
+        if (IsKeyPressed(KEY_F5)) { gEngineSide = gEngineSide == -1 ? 0 : gEngineSide == 0 ? 1 : -1; engineToggled = true; }
+        if (engineToggled && !gPendingTurnSwitch && !gPromo.active) engine_on_position_changed();
+        if (engine_poll_results()) dirty = true;
+
         // ESC: modal -> cierra modal; si no hay modal, salir
         if (IsKeyPressed(KEY_ESCAPE)) {
             if (gPromo.active) gPromo.active = false;
@@ -282,84 +618,27 @@ int main(void) {
         int mx = GetMouseX(), my = GetMouseY();
         int f=-1, r=-1; pixel_to_square(mx, my, SQ, &f, &r);
         int hoverSq = (f==-1 || r==-1) ? -1 : (r*8 + f);
+        if (hoverSq != lastHoverSq) { lastHoverSq = hoverSq; dirty = true; }
 
-        // Bloqueo de input si hay animación, promoción o game over
-        bool inputLocked = gAnim.active || gAnimR.active || gPromo.active || gGameOver;
+        // Bloqueo de input si hay animación, promoción, game over o juega el motor
+        bool inputLocked = gAnim.active || gAnimR.active || gPromo.active || gGameOver ||
+                           gSideToMove == gEngineSide;
 
         // Clic izquierdo: seleccionar o mover
         if (!inputLocked && IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && hoverSq != -1) {
             if (gSelectedSq == -1) {
-                if ((gSideToMove==1 && is_white_at(hoverSq)) ||
-                    (gSideToMove==0 && is_black_at(hoverSq))) {
+                if ((gSideToMove==1 && is_white_at(&gPos, hoverSq)) ||
+                    (gSideToMove==0 && is_black_at(&gPos, hoverSq))) {
                     gSelectedSq = hoverSq;
-                    gMoveTargets = gen_legal_moves_from(gSelectedSq, gSideToMove);
+                    gMoveTargets = gTurn.targets[gSelectedSq];
                 }
             } else {
                 if ((gMoveTargets & bit_at(hoverSq)) && hoverSq != gSelectedSq) {
                     // ¿Promoción?
-                    if (would_promote(gSelectedSq, hoverSq, gSideToMove)) {
+                    if (gTurn.promoFrom & bit_at(gSelectedSq)) {
                         gPromo = (PromotionUI){ true, gSelectedSq, hoverSq, gSideToMove };
                     } else {
-                        // Animación de movimiento normal
-                        int movingTex = piece_index_at_tex(gSelectedSq); // antes de mover
-
-                        // ¿Es enroque?
-                        bool isWhite = (gSideToMove == 1);
-                        bool isKingMove = (movingTex == (isWhite ? TEX_WK : TEX_BK));
-                        bool isCastleShort =
-                            (isWhite && gSelectedSq == square_index(4,0) && hoverSq == square_index(6,0)) ||
-                            (!isWhite && gSelectedSq == square_index(4,7) && hoverSq == square_index(6,7));
-                        bool isCastleLong  =
-                            (isWhite && gSelectedSq == square_index(4,0) && hoverSq == square_index(2,0)) ||
-                            (!isWhite && gSelectedSq == square_index(4,7) && hoverSq == square_index(2,7));
-                        bool isCastle = isKingMove && (isCastleShort || isCastleLong);
-
-                        // ¿Captura normal en destino? (calcular ANTES de mover)
-                        bool isCapture = (gSideToMove == 1) ? is_black_at(hoverSq) : is_white_at(hoverSq);
-
-                        // ¿En-passant?
-                        int codeFrom = piece_code_at(gSelectedSq); // 0=WP, 6=BP
-                        bool isEP = false;
-                        int epSq = get_ep_square(); // -1 si no hay
-                        if ((codeFrom == 0 || codeFrom == 6) && epSq != -1 && hoverSq == epSq) {
-                            isEP = true;
-                        }
-
-                        // Calcular de antemano la torre (move_make ya la mueve)
-                        int rookFrom = -1, rookTo = -1, rookTex = -1;
-                        if (isCastle) {
-                            if (isWhite) {
-                                if (isCastleShort) { rookFrom = square_index(7,0); rookTo = square_index(5,0); rookTex = TEX_WR; }
-                                else               { rookFrom = square_index(0,0); rookTo = square_index(3,0); rookTex = TEX_WR; }
-                            } else {
-                                if (isCastleShort) { rookFrom = square_index(7,7); rookTo = square_index(5,7); rookTex = TEX_BR; }
-                                else               { rookFrom = square_index(0,7); rookTo = square_index(3,7); rookTex = TEX_BR; }
-                            }
-                        }
-
-                        if (move_make(gSelectedSq, hoverSq, gSideToMove, -1)) {
-                            // Sonidos (usar info previa al movimiento)
-                            if (isCastle) {
-                                PlaySound(sndCastle);
-                            } else if (isEP || isCapture) {
-                                PlaySound(sndCapture);
-                            } else {
-                                PlaySound(sndMove);
-                            }
-
-                            // Animación del REY
-                            gAnim = (MoveAnim){ true, gSelectedSq, hoverSq, movingTex, 0.0f, 0.18f };
-
-                            // Si fue enroque, también animamos la TORRE
-                            if (isCastle && rookFrom != -1) {
-                                gAnimR = (MoveAnim){ true, rookFrom, rookTo, rookTex, 0.0f, 0.18f };
-                            } else {
-                                gAnimR.active = false;
-                            }
-
-                            // Cambiar turno al finalizar TODAS las animaciones
-                            gPendingTurnSwitch = true;
-                        }
+                        play_move_animated(gSelectedSq, hoverSq);
                     }
                 }
                 gSelectedSq = -1;
@@ -374,65 +653,46 @@ int main(void) {
         }
 
         // Avance de animaciones (rey y torre)
+        if (gAnim.active || gAnimR.active || gPendingTurnSwitch || gShowDebug) dirty = true;
         if (gAnim.active) {
-            gAnim.t += GetFrameTime() / gAnim.duration;
+            gAnim.t += dt / gAnim.duration;
             if (gAnim.t >= 1.0f) { gAnim.t = 1.0f; gAnim.active = false; }
         }
         if (gAnimR.active) {
-            gAnimR.t += GetFrameTime() / gAnimR.duration;
+            gAnimR.t += dt / gAnimR.duration;
             if (gAnimR.t >= 1.0f) { gAnimR.t = 1.0f; gAnimR.active = false; }
         }
 
         // Cuando no quedan animaciones pendientes, cambiamos el turno y chequeamos mate/ahogado
         if (gPendingTurnSwitch && !gAnim.active && !gAnimR.active) {
             gPendingTurnSwitch = false;
-            gSideToMove = 1 - gSideToMove;
-            check_game_over_after_turn_change();
+            switch_turn();
+        }
 
-            // Sonido de jaque (al comenzar el turno en jaque)
-            if (!gGameOver && is_king_in_check(gSideToMove)) {
-                PlaySound(sndCheck);
-            }
+        // Nada cambió: no dibujar. Con el motor pensando se revisa su cola
+        // ~60 veces por segundo; si no, PollInputEvents duerme hasta un evento.
+        if (!dirty) {
+            update_event_waiting();
+            if (gEngineReq != 0) WaitTime(1.0 / 60.0);
+            PollInputEvents();
+            continue;
         }
+        dirty = false;
 
         // --------- DIBUJO ---------
         BeginDrawing();
         ClearBackground(RAYWHITE);
 
-        draw_board(SQ, COL_LIGHT, COL_DARK);
+        draw_board_layer();
         draw_pieces_textured(SQ);
 
-        // Capa de animación de la TORRE (enroque)
-        if (gAnimR.active && gAnimR.texIdx >= 0) {
-            int f0 = gAnimR.fromSq % 8, r0 = gAnimR.fromSq / 8;
-            int f1 = gAnimR.toSq   % 8, r1 = gAnimR.toSq   / 8;
-
-            int x0, y0, x1, y1;
-            square_to_xy(f0, r0, SQ, &x0, &y0);
-            square_to_xy(f1, r1, SQ, &x1, &y1);
+        // Capa de animación: pieza movida y, en enroques, la TORRE
+        draw_anim(&gAnim, SQ);
+        draw_anim(&gAnimR, SQ);
 
-            float t = easeInOutCubic(gAnimR.t);
-            float cx = x0 + (x1 - x0) * t;
-            float cy = y0 + (y1 - y0) * t;
-
-            Texture2D tex = gPieceTex[gAnimR.texIdx];
-            float scalePad = 0.90f;
-            float scale = scalePad * (float)SQ / (float)((tex.width > tex.height) ? tex.width : tex.height);
-            float w = tex.width * scale, h = tex.height * scale;
-
-            Rectangle src = (Rectangle){0,0,(float)tex.width,(float)tex.height};
-            Rectangle dst = (Rectangle){ cx + (SQ - w)*0.5f, cy + (SQ - h)*0.5f, w, h };
-            DrawTexturePro(tex, src, dst, (Vector2){0,0}, 0, WHITE);
-        }
-
-        // Resaltar al rey si está en jaque
-        if (!gGameOver && is_king_in_check(gSideToMove)) {
-            int kingSq = -1;
-            if (gSideToMove == 1) { // blancas
-                for (int sq = 0; sq < 64; sq++) { if (WK & bit_at(sq)) { kingSq = sq; break; } }
-            } else {
-                for (int sq = 0; sq < 64; sq++) { if (BK & bit_at(sq)) { kingSq = sq; break; } }
-            }
+        // Resaltar al rey si está en jaque (mientras se anima la jugada, gTurn es del turno anterior)
+        if (!gGameOver && !gPendingTurnSwitch && gTurn.inCheck) {
+            int kingSq = gTurn.kingSq;
             if (kingSq != -1) {
                 int kf = kingSq % 8, kr = kingSq / 8, x, y;
                 square_to_xy(kf, kr, SQ, &x, &y);
@@ -469,27 +729,16 @@ int main(void) {
         }
 
         // debug
-        if (gShowDebug) {
-            DrawRectangle(12, 12, 150, 80, DBG_BG);
-            if (f!=-1) DrawText(TextFormat("file=%d  rank=%d", f+1, r+1), 20, 18, 20, DBG_FG);
-            DrawText(gSideToMove ? "Turno: Blancas" : "Turno: Negras", 20, 40, 18, DBG_FG);
-            DrawText(is_king_in_check(gSideToMove) ? "¡Jaque!" : "", 20, 58, 18, RED);
-            DrawText(gGameOver ? "GAME OVER" : "", 20, 72, 18, ORANGE);
-        }
+        if (gShowDebug) draw_debug_overlay(f, r);
+
+        draw_engine_panel(SQ);
 
         // Modal de promoción
         if (gPromo.active && !gGameOver) {
             int promoCode = draw_and_pick_promotion(SQ);
             if (promoCode != -1) {
-                if (move_make(gPromo.fromSq, gPromo.toSq, gPromo.side, promoCode)) {
-                    PlaySound(sndPromo);
-                    gSideToMove = 1 - gSideToMove;
-                    check_game_over_after_turn_change();
-                    if (!gGameOver && is_king_in_check(gSideToMove)) {
-                        PlaySound(sndCheck);
-                    }
-                }
                 gPromo.active = false;
+                play_promotion(gPromo.fromSq, gPromo.toSq, promoCode);
             }
         }
 
@@ -504,10 +753,18 @@ int main(void) {
                      HH/2 + 28, 18, LIGHTGRAY);
         }
 
+        // el modal de promoción puede haber jugado: decidir la espera recién acá
+        update_event_waiting();
+#ifdef CHESS_STATS
+        // GetFrameTime incluiría lo dormido esperando eventos: se mide desde
+        // el principio de la vuelta hasta antes de EndDrawing (swap y espera)
+        gFrameWorkMs = (GetTime() - now) * 1000.0;
+#endif
         EndDrawing();
     }
 
     // Descarga
+    engine_quit(gEngine);
     UnloadSound(sndMove);
     UnloadSound(sndCapture);
     UnloadSound(sndCastle);
@@ -0,0 +1,400 @@
+// chess-microbench: costo por llamada (ns/op) de las primitivas de board.c.
+// Corre cada primitiva sobre un corpus de posiciones variadas (la suite de
+// perft más partidas al azar desde ellas), con calentamiento, el hilo fijado
+// a una CPU y varias repeticiones; informa mediana y percentiles. Con
+// --baseline compara contra una corrida anterior guardada con --json y sale
+// con código 1 si alguna primitiva empeoró más que la tolerancia.
+//
+// Uso: chess-microbench [--reps N] [--sample-ms MS] [--warmup-ms MS] [--cpu N]
+//                       [--filter TEXTO] [--json] [--baseline archivo.json]
+//                       [--tolerance PCT] [--scalar]
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include "board.h"
+#include "clock.h"
+
+/* ---------------- Corpus ---------------- */
+// Semillas: las posiciones de la suite de perft (apertura, medio juego,
+// finales, EP, promociones). Desde cada una se juegan partidas al azar y se
+// guarda cada posición alcanzada.
+static const char *SEEDS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1",
+    "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1",
+    "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1",
+    "8/P1k5/K7/8/8/8/8/8 w - - 0 1",
+};
+#define NUM_SEEDS ((int)(sizeof(SEEDS) / sizeof(SEEDS[0])))
+#define WALKS_PER_SEED 4
+#define WALK_PLIES     12
+#define CORPUS_MAX     (NUM_SEEDS * (WALKS_PER_SEED * WALK_PLIES + 1))
+
+static Position gCorpus[CORPUS_MAX];
+static int      gCorpusSize = 0;
+
+// xorshift64: mismo corpus en cada corrida (comparable contra la línea base)
+static uint64_t rng_next(uint64_t *s) {
+    *s ^= *s << 13; *s ^= *s >> 7; *s ^= *s << 17;
+    return *s;
+}
+
+static int build_corpus(void) {
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < NUM_SEEDS; ++i) {
+        Position root;
+        if (!position_from_fen(&root, SEEDS[i])) { fprintf(stderr, "FEN inválido: %s\n", SEEDS[i]); return 0; }
+        gCorpus[gCorpusSize++] = root;
+        for (int w = 0; w < WALKS_PER_SEED; ++w) {
+            Position pos = root;
+            for (int ply = 0; ply < WALK_PLIES; ++ply) {
+                MoveList list;
+                gen_legal_moves(&pos, &list);
+                if (list.count == 0) break;  // mate o ahogado: la posición ya está
+                move_make(&pos, list.moves[rng_next(&seed) % (uint64_t)list.count], NULL);
+                gCorpus[gCorpusSize++] = pos;
+            }
+        }
+    }
+    // las variantes ":cache" miden con los dos mapas de ataques ya calculados
+    for (int i = 0; i < gCorpusSize; ++i) position_refresh_attacks(&gCorpus[i]);
+    return 1;
+}
+
+/* ---------------- Primitivas ---------------- */
+// Cada función recorre el corpus una vez y devuelve cuántas llamadas hizo.
+// Los resultados van a gSink para que el compilador no descarte nada.
+// Las variantes "fría" consultan sin caché de ataques, como queda la posición
+// tras move_unmake (las consultas const no la llenan: cada llamada calcula el
+// mapa); las ":cache" usan los dos mapas ya calculados.
+typedef uint64_t (*BenchFn)(int arg);
+
+static volatile uint64_t gSink;
+
+static uint64_t own_pieces(const Position *pos, int type) {
+    return pos->bb[(pos->side == 1 ? WP : BP) + type];
+}
+
+static uint64_t bench_piece_code_at(int arg) {
+    uint64_t acc = 0;
+    for (int i = 0; i < gCorpusSize; ++i)
+        for (int sq = 0; sq < 64; ++sq) acc += (uint64_t)piece_code_at(&gCorpus[i], sq);
+    gSink += acc;
+    return (uint64_t)gCorpusSize * 64;
+}
+
+// arg = tipo de pieza (0=P .. 5=K) del bando que mueve
+static uint64_t bench_gen_moves_from(int arg) {
+    uint64_t acc = 0, ops = 0;
+    for (int i = 0; i < gCorpusSize; ++i) {
+        Position *pos = &gCorpus[i];
+        int valid = pos->attacksValid;
+        pos->attacksValid = 0;
+        for (uint64_t b = own_pieces(pos, arg); b; b &= b - 1, ++ops)
+            acc += gen_moves_from(pos, __builtin_ctzll(b));
+        pos->attacksValid = valid;
+    }
+    gSink += acc;
+    return ops;
+}
+
+static uint64_t bench_gen_legal_moves_from(int arg) {
+    uint64_t acc = 0, ops = 0;
+    for (int i = 0; i < gCorpusSize; ++i) {
+        Position *pos = &gCorpus[i];
+        uint64_t own = pos->side == 1 ? occ_white(pos) : occ_black(pos);
+        int valid = pos->attacksValid;
+        if (!arg) pos->attacksValid = 0;
+        for (uint64_t b = own; b; b &= b - 1, ++ops)
+            acc += gen_legal_moves_from(pos, __builtin_ctzll(b));
+        pos->attacksValid = valid;
+    }
+    gSink += acc;
+    return ops;
+}
+
+// Una consulta por casilla, alternando el bando atacante
+static uint64_t bench_square_attacked(int arg) {
+    uint64_t acc = 0;
+    for (int i = 0; i < gCorpusSize; ++i) {
+        Position *pos = &gCorpus[i];
+        int valid = pos->attacksValid;
+        if (!arg) pos->attacksValid = 0;
+        for (int sq = 0; sq < 64; ++sq)
+            acc += (uint64_t)is_square_attacked_by_side(pos, sq, sq & 1);
+        pos->attacksValid = valid;
+    }
+    gSink += acc;
+    return (uint64_t)gCorpusSize * 64;
+}
+
+static uint64_t bench_king_in_check(int arg) {
+    uint64_t acc = 0;
+    for (int i = 0; i < gCorpusSize; ++i) {
+        Position *pos = &gCorpus[i];
+        int valid = pos->attacksValid;
+        if (!arg) pos->attacksValid = 0;
+        for (int side = 0; side < 2; ++side)
+            acc += (uint64_t)is_king_in_check(pos, side);
+        pos->attacksValid = valid;
+    }
+    gSink += acc;
+    return (uint64_t)gCorpusSize * 2;
+}
+
+// move_make + move_unmake de cada jugada legal (la lista se arma fuera del reloj)
+static MoveList gCorpusMoves[CORPUS_MAX];
+
+static uint64_t bench_make_unmake(int arg) {
+    uint64_t acc = 0, ops = 0;
+    for (int i = 0; i < gCorpusSize; ++i) {
+        Position *pos = &gCorpus[i];
+        const MoveList *list = &gCorpusMoves[i];
+        uint64_t atk0 = pos->attacks[0], atk1 = pos->attacks[1];
+        int valid = pos->attacksValid;
+        for (int k = 0; k < list->count; ++k, ++ops) {
+            Undo u;
+            move_make(pos, list->moves[k], &u);
+            acc += pos->key;
+            move_unmake(pos, list->moves[k], &u);
+        }
+        // unmake deja la caché vacía: se repone para las variantes ":cache"
+        pos->attacks[0] = atk0; pos->attacks[1] = atk1;
+        pos->attacksValid = valid;
+    }
+    gSink += acc;
+    return ops;
+}
+
+typedef struct {
+    const char *name;
+    BenchFn     fn;
+    int         arg;
+} Bench;
+
+static const Bench BENCHES[] = {
+    { "piece_code_at",                    bench_piece_code_at,        0 },
+    { "gen_moves_from:P",                 bench_gen_moves_from,       0 },
+    { "gen_moves_from:N",                 bench_gen_moves_from,       1 },
+    { "gen_moves_from:B",                 bench_gen_moves_from,       2 },
+    { "gen_moves_from:R",                 bench_gen_moves_from,       3 },
+    { "gen_moves_from:Q",                 bench_gen_moves_from,       4 },
+    { "gen_moves_from:K",                 bench_gen_moves_from,       5 },
+    { "gen_legal_moves_from",             bench_gen_legal_moves_from, 0 },
+    { "gen_legal_moves_from:cache",       bench_gen_legal_moves_from, 1 },
+    { "is_square_attacked_by_side",       bench_square_attacked,      0 },
+    { "is_square_attacked_by_side:cache", bench_square_attacked,      1 },
+    { "is_king_in_check",                 bench_king_in_check,        0 },
+    { "is_king_in_check:cache",           bench_king_in_check,        1 },
+    { "move_make+unmake",                 bench_make_unmake,          0 },
+};
+#define NUM_BENCHES ((int)(sizeof(BENCHES) / sizeof(BENCHES[0])))
+
+/* ---------------- Opciones ---------------- */
+#define MAX_REPS 1000
+
+typedef struct {
+    int         reps;        // muestras por primitiva
+    int         sampleMs;    // duración mínima de cada muestra
+    int         warmupMs;    // calentamiento por primitiva
+    int         cpu;         // -1 = no fijar
+    const char *filter;      // sólo primitivas cuyo nombre contenga esto
+    int         json;
+    const char *baseline;    // salida --json de una corrida anterior
+    double      tolerance;   // % de empeoramiento de la mediana que se acepta
+    int         scalar;
+} Options;
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Uso: %s [--reps N] [--sample-ms MS] [--warmup-ms MS] [--cpu N] [--filter TEXTO]\n"
+            "          [--json] [--baseline archivo.json] [--tolerance PCT] [--scalar]\n"
+            "  --reps N        muestras por primitiva (por defecto 31)\n"
+            "  --sample-ms MS  duración mínima de cada muestra (por defecto 5)\n"
+            "  --warmup-ms MS  calentamiento por primitiva (por defecto 100)\n"
+            "  --cpu N         fijar el hilo a la CPU N (por defecto 0; -1 = no fijar)\n"
+            "  --filter TEXTO  sólo las primitivas cuyo nombre contenga TEXTO\n"
+            "  --json          una línea JSON por primitiva (sirve como línea base)\n"
+            "  --baseline F    comparar medianas contra F; código 1 si hay regresiones\n"
+            "  --tolerance P   %% de empeoramiento aceptado (por defecto 10)\n"
+            "  --scalar        mapas de ataques sin AVX2\n",
+            argv0);
+}
+
+static int parse_args(int argc, char **argv, Options *o) {
+    *o = (Options){ 31, 5, 100, 0, NULL, 0, NULL, 10.0, 0 };
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        int hasVal = (i + 1 < argc);
+        if      (!strcmp(a, "--reps")      && hasVal) o->reps      = atoi(argv[++i]);
+        else if (!strcmp(a, "--sample-ms") && hasVal) o->sampleMs  = atoi(argv[++i]);
+        else if (!strcmp(a, "--warmup-ms") && hasVal) o->warmupMs  = atoi(argv[++i]);
+        else if (!strcmp(a, "--cpu")       && hasVal) o->cpu       = atoi(argv[++i]);
+        else if (!strcmp(a, "--filter")    && hasVal) o->filter    = argv[++i];
+        else if (!strcmp(a, "--baseline")  && hasVal) o->baseline  = argv[++i];
+        else if (!strcmp(a, "--tolerance") && hasVal) o->tolerance = atof(argv[++i]);
+        else if (!strcmp(a, "--json"))   o->json   = 1;
+        else if (!strcmp(a, "--scalar")) o->scalar = 1;
+        else { usage(argv[0]); return 0; }
+    }
+    if (o->reps <= 0 || o->reps > MAX_REPS || o->sampleMs <= 0 || o->warmupMs < 0) { usage(argv[0]); return 0; }
+    return 1;
+}
+
+// Fija el hilo a una CPU para que el planificador no lo mueva entre muestras
+static int pin_cpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return 0;
+#endif
+}
+
+/* ---------------- Línea base ---------------- */
+#define NAME_MAX_LEN 48
+
+typedef struct {
+    char   name[NAME_MAX_LEN];
+    double medianNs;
+} BaselineEntry;
+
+static BaselineEntry gBaseline[NUM_BENCHES * 4];
+static int           gBaselineSize = 0;
+
+// Lee las líneas {"name":"...","median_ns":X,...} que escribe --json
+static int load_baseline(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    char line[512];
+    while (fgets(line, sizeof(line), f) && gBaselineSize < (int)(sizeof(gBaseline) / sizeof(gBaseline[0]))) {
+        const char *n = strstr(line, "\"name\":\"");
+        const char *m = strstr(line, "\"median_ns\":");
+        if (!n || !m) continue;
+        n += 8;
+        size_t len = strcspn(n, "\"");
+        if (len >= NAME_MAX_LEN) continue;
+        BaselineEntry *e = &gBaseline[gBaselineSize++];
+        memcpy(e->name, n, len);
+        e->name[len] = '\0';
+        e->medianNs = strtod(m + 12, NULL);
+    }
+    fclose(f);
+    return 1;
+}
+
+static const BaselineEntry *baseline_find(const char *name) {
+    for (int i = 0; i < gBaselineSize; ++i)
+        if (!strcmp(gBaseline[i].name, name)) return &gBaseline[i];
+    return NULL;
+}
+
+/* ---------------- Medición ---------------- */
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil p (0..1) de muestras ya ordenadas
+static double percentile(const double *s, int n, double p) {
+    return s[(int)(p * (double)(n - 1) + 0.5)];
+}
+
+typedef struct {
+    uint64_t ops;     // llamadas por muestra
+    double   minNs, p10Ns, medianNs, p90Ns;
+} BenchResult;
+
+static void run_bench(const Bench *b, const Options *o, BenchResult *r) {
+    // calentamiento: caches, predictor de saltos y frecuencia de la CPU
+    uint64_t opsPerPass = 0;
+    double t0 = clock_now(), passSecs;
+    int passes = 0;
+    do {
+        opsPerPass = b->fn(b->arg);
+        passes++;
+    } while (clock_now() - t0 < o->warmupMs * 1e-3);
+    passSecs = (clock_now() - t0) / passes;
+
+    // pasadas por muestra para llegar a sampleMs (el reloj se lee dos veces por muestra)
+    int perSample = (int)(o->sampleMs * 1e-3 / (passSecs > 0.0 ? passSecs : 1e-9)) + 1;
+
+    static double samples[MAX_REPS];
+    for (int rep = 0; rep < o->reps; ++rep) {
+        double s0 = clock_now();
+        for (int k = 0; k < perSample; ++k) b->fn(b->arg);
+        double secs = clock_now() - s0;
+        samples[rep] = secs * 1e9 / ((double)opsPerPass * perSample);
+    }
+    qsort(samples, (size_t)o->reps, sizeof(double), cmp_double);
+    r->ops = opsPerPass * (uint64_t)perSample;
+    r->minNs = samples[0];
+    r->p10Ns = percentile(samples, o->reps, 0.10);
+    r->medianNs = percentile(samples, o->reps, 0.50);
+    r->p90Ns = percentile(samples, o->reps, 0.90);
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!parse_args(argc, argv, &o)) return 2;
+    board_force_scalar(o.scalar);
+    if (o.baseline && !load_baseline(o.baseline)) { fprintf(stderr, "No se pudo leer %s\n", o.baseline); return 2; }
+    int pinned = o.cpu >= 0 && pin_cpu(o.cpu);
+    if (o.cpu >= 0 && !pinned) fprintf(stderr, "Aviso: no se pudo fijar la CPU %d; las medidas tendrán más ruido\n", o.cpu);
+
+    if (!build_corpus()) return 2;
+    for (int i = 0; i < gCorpusSize; ++i) gen_legal_moves(&gCorpus[i], &gCorpusMoves[i]);
+
+    if (!o.json) {
+        printf("Microbenchmark: %d posiciones, %d muestras, ataques: %s, CPU %s\n",
+               gCorpusSize, o.reps, board_slider_kernel(), pinned ? "fija" : "libre");
+        printf("%-34s %9s %9s %9s %9s", "primitiva", "min", "p10", "mediana", "p90");
+        if (o.baseline) printf(" %9s %8s", "base", "delta");
+        printf("   (ns/op)\n");
+    }
+
+    int regressions = 0;
+    for (int i = 0; i < NUM_BENCHES; ++i) {
+        const Bench *b = &BENCHES[i];
+        if (o.filter && !strstr(b->name, o.filter)) continue;
+        BenchResult r;
+        run_bench(b, &o, &r);
+
+        const BaselineEntry *base = o.baseline ? baseline_find(b->name) : NULL;
+        double delta = base && base->medianNs > 0.0 ? 100.0 * (r.medianNs - base->medianNs) / base->medianNs : 0.0;
+        int regressed = base && delta > o.tolerance;
+        regressions += regressed;
+
+        if (o.json) {
+            printf("{\"name\":\"%s\",\"ops\":%llu,\"reps\":%d,\"min_ns\":%.3f,\"p10_ns\":%.3f,"
+                   "\"median_ns\":%.3f,\"p90_ns\":%.3f,\"kernel\":\"%s\"",
+                   b->name, (unsigned long long)r.ops, o.reps, r.minNs, r.p10Ns, r.medianNs, r.p90Ns,
+                   board_slider_kernel());
+            if (base) printf(",\"baseline_ns\":%.3f,\"delta_pct\":%.2f,\"regressed\":%s",
+                             base->medianNs, delta, regressed ? "true" : "false");
+            printf("}\n");
+        } else {
+            printf("%-34s %9.2f %9.2f %9.2f %9.2f", b->name, r.minNs, r.p10Ns, r.medianNs, r.p90Ns);
+            if (base)            printf(" %9.2f %+7.1f%%%s", base->medianNs, delta, regressed ? "  REGRESIÓN" : "");
+            else if (o.baseline) printf(" %9s", "-");
+            printf("\n");
+        }
+        fflush(stdout);
+    }
+
+    if (o.baseline && !o.json)
+        printf("%d regresiones (tolerancia %.1f%%)\n", regressions, o.tolerance);
+    return regressions ? 1 : 0;
+}
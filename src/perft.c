@@ -0,0 +1,214 @@
+#include "perft.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+/* ---------------- Tareas ----------------
+ * Una tarea es un camino de 1 o 2 movimientos desde la raíz; el hilo lo
+ * juega sobre su copia de la posición y cuenta el resto del árbol.
+ */
+typedef struct {
+    Move     path[2];
+    int      len;       // 1 = movimiento raíz, 2 = raíz + respuesta
+    int      root;      // índice del movimiento raíz al que suma
+    uint64_t nodes;     // resultado
+} PerftTask;
+
+// Cola de cada hilo: el dueño saca del final, los ladrones del principio
+typedef struct {
+    pthread_mutex_t lock;
+    int *items;
+    int  head, tail;
+} TaskDeque;
+
+typedef struct {
+    const Position *root;
+    int             depth;
+    PerftTask      *tasks;
+    TaskDeque      *deques;
+    int             nthreads;
+    PerftTable     *tt;        // compartida (puede ser NULL)
+    pthread_mutex_t statsLock; // para sumar probes/hits de cada hilo
+} PerftJob;
+
+typedef struct {
+    PerftJob *job;
+    int       id;
+} PerftWorker;
+
+static int deque_pop(TaskDeque *d) {
+    int t = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head) t = d->items[--d->tail];
+    pthread_mutex_unlock(&d->lock);
+    return t;
+}
+
+static int deque_steal(TaskDeque *d) {
+    int t = -1;
+    pthread_mutex_lock(&d->lock);
+    if (d->tail > d->head) t = d->items[d->head++];
+    pthread_mutex_unlock(&d->lock);
+    return t;
+}
+
+static void *perft_worker(void *arg) {
+    PerftWorker *w = (PerftWorker*)arg;
+    PerftJob *job = w->job;
+    Position pos = *job->root; // copia propia
+
+    // Vista propia de la tabla: mismas entradas, contadores privados. Sólo se
+    // copian los campos fijos: probes/hits los suman los otros hilos al terminar.
+    PerftTable local, *tt = NULL;
+    if (job->tt) {
+        local.entries = job->tt->entries;
+        local.mask    = job->tt->mask;
+        local.probes  = local.hits = 0;
+        tt = &local;
+    }
+
+    for (;;) {
+        int t = deque_pop(&job->deques[w->id]);
+        for (int k = 1; t < 0 && k < job->nthreads; ++k)
+            t = deque_steal(&job->deques[(w->id + k) % job->nthreads]);
+        if (t < 0) break; // no se generan tareas nuevas: nada más que hacer
+
+        PerftTask *task = &job->tasks[t];
+        Undo u[2];
+        for (int i = 0; i < task->len; ++i) move_make(&pos, task->path[i], &u[i]);
+        task->nodes = perft_hashed(&pos, job->depth - task->len, tt);
+        for (int i = task->len - 1; i >= 0; --i) move_unmake(&pos, task->path[i], &u[i]);
+    }
+
+    if (tt) {
+        pthread_mutex_lock(&job->statsLock);
+        job->tt->probes += local.probes;
+        job->tt->hits   += local.hits;
+        pthread_mutex_unlock(&job->statsLock);
+    }
+    return NULL;
+}
+
+int perft_default_threads(void) {
+#if defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0) return (int)n;
+#endif
+    return 1;
+}
+
+// Sin memoria para repartir: cada movimiento raíz en este hilo
+static void divide_serial(const Position *pos, int depth, PerftTable *tt,
+                          const MoveList *moves, uint64_t counts[]) {
+    Position tmp = *pos;
+    for (int i = 0; i < moves->count; ++i) {
+        Undo u;
+        move_make(&tmp, moves->moves[i], &u);
+        counts[i] = perft_hashed(&tmp, depth - 1, tt);
+        move_unmake(&tmp, moves->moves[i], &u);
+    }
+}
+
+uint64_t perft_parallel_divide(const Position *pos, int depth, int threads, PerftTable *tt,
+                               MoveList *moves, uint64_t counts[]) {
+    gen_legal_moves(pos, moves);
+    for (int i = 0; i < moves->count; ++i) counts[i] = 0;
+    if (depth <= 0) { moves->count = 0; return 1ULL; }
+    if (depth == 1) { for (int i = 0; i < moves->count; ++i) counts[i] = 1; return (uint64_t)moves->count; }
+    if (threads <= 0) threads = perft_default_threads();
+
+    // Si la raíz no alcanza para repartir bien, bajamos un nivel más
+    int split = (depth >= 3 && moves->count < threads * 4);
+
+    int cap = split ? moves->count * MAX_MOVES : moves->count;
+    PerftTask *tasks = (PerftTask*)malloc(sizeof(PerftTask) * (cap ? cap : 1));
+    if (!tasks) {
+        fprintf(stderr, "perft: sin memoria para las tareas, sigo en un solo hilo\n");
+        divide_serial(pos, depth, tt, moves, counts);
+        uint64_t total = 0ULL;
+        for (int i = 0; i < moves->count; ++i) total += counts[i];
+        return total;
+    }
+    int ntasks = 0;
+    Position tmp = *pos;
+    for (int i = 0; i < moves->count; ++i) {
+        if (!split) {
+            tasks[ntasks++] = (PerftTask){ { moves->moves[i], MOVE_NONE }, 1, i, 0 };
+            continue;
+        }
+        Undo u;
+        MoveList replies;
+        move_make(&tmp, moves->moves[i], &u);
+        gen_legal_moves(&tmp, &replies);
+        for (int j = 0; j < replies.count; ++j)
+            tasks[ntasks++] = (PerftTask){ { moves->moves[i], replies.moves[j] }, 2, i, 0 };
+        move_unmake(&tmp, moves->moves[i], &u);
+    }
+
+    if (threads > ntasks) threads = ntasks > 0 ? ntasks : 1;
+
+    // Reparto inicial round-robin; después cada uno roba lo que le falte
+    PerftJob job;
+    job.root = pos; job.depth = depth; job.tasks = tasks; job.nthreads = threads; job.tt = tt;
+    job.deques = (TaskDeque*)malloc(sizeof(TaskDeque) * threads);
+    int per = (ntasks + threads - 1) / threads;
+    int *slots = (int*)malloc(sizeof(int) * (per ? per * threads : 1));
+    PerftWorker *workers = (PerftWorker*)malloc(sizeof(PerftWorker) * threads);
+    pthread_t *tids = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    if (!job.deques || !slots || !workers || !tids) {
+        fprintf(stderr, "perft: sin memoria para los hilos, sigo en un solo hilo\n");
+        free(tids); free(workers); free(slots); free(job.deques); free(tasks);
+        divide_serial(pos, depth, tt, moves, counts);
+        uint64_t total = 0ULL;
+        for (int i = 0; i < moves->count; ++i) total += counts[i];
+        return total;
+    }
+    pthread_mutex_init(&job.statsLock, NULL);
+    for (int w = 0; w < threads; ++w) {
+        TaskDeque *d = &job.deques[w];
+        pthread_mutex_init(&d->lock, NULL);
+        d->items = slots + w * per;
+        d->head = d->tail = 0;
+        for (int t = w; t < ntasks; t += threads) d->items[d->tail++] = t;
+    }
+
+    // Si un hilo no arranca, sus tareas quedan en su cola y las roban los demás
+    int started = 1;
+    for (int w = 0; w < threads; ++w) workers[w] = (PerftWorker){ &job, w };
+    while (started < threads && pthread_create(&tids[started], NULL, perft_worker, &workers[started]) == 0)
+        started++;
+    perft_worker(&workers[0]); // el hilo que llama también trabaja
+    for (int w = 1; w < started; ++w) pthread_join(tids[w], NULL);
+
+    // Suma en orden fijo: el resultado no depende de quién hizo qué
+    uint64_t total = 0ULL;
+    for (int t = 0; t < ntasks; ++t) counts[tasks[t].root] += tasks[t].nodes;
+    for (int i = 0; i < moves->count; ++i) total += counts[i];
+
+    for (int w = 0; w < threads; ++w) pthread_mutex_destroy(&job.deques[w].lock);
+    pthread_mutex_destroy(&job.statsLock);
+    free(tids); free(workers); free(slots); free(job.deques); free(tasks);
+    return total;
+}
+
+uint64_t perft_parallel(const Position *pos, int depth, int threads, PerftTable *tt) {
+    MoveList moves;
+    uint64_t counts[MAX_MOVES];
+    return perft_parallel_divide(pos, depth, threads, tt, &moves, counts);
+}
+
+void perft_divide_parallel(const Position *pos, int depth, int threads, PerftTable *tt) {
+    if (depth <= 0) { printf("depth debe ser >= 1\n"); return; }
+
+    MoveList moves;
+    uint64_t counts[MAX_MOVES];
+    uint64_t total = perft_parallel_divide(pos, depth, threads, tt, &moves, counts);
+    for (int i = 0; i < moves.count; ++i) {
+        char uci[6]; move_to_uci(moves.moves[i], uci);
+        printf("%s: %llu\n", uci, (unsigned long long)counts[i]);
+    }
+    printf("Total: %llu\n", (unsigned long long)total);
+}
@@ -0,0 +1,25 @@
+#ifndef PERFT_H
+#define PERFT_H
+#include "board.h"
+
+// ----- Perft en paralelo -----
+// Reparte los movimientos raíz entre 'threads' hilos (y, si la raíz tiene
+// pocos movimientos, también las respuestas de segundo nivel). Cada hilo
+// trabaja sobre su propia copia de la posición y roba tareas de los demás
+// cuando se queda sin trabajo. 'tt' es opcional y se comparte entre hilos.
+// threads <= 0: usar todos los núcleos.
+
+// Nº de núcleos disponibles (1 si no se puede saber)
+int perft_default_threads(void);
+
+uint64_t perft_parallel(const Position *pos, int depth, int threads, PerftTable *tt);
+
+// Conteo por movimiento raíz, en el orden de gen_legal_moves. 'counts'
+// necesita MAX_MOVES entradas. Devuelve el total.
+uint64_t perft_parallel_divide(const Position *pos, int depth, int threads, PerftTable *tt,
+                               MoveList *moves, uint64_t counts[]);
+
+// Igual que perft_divide (mismo formato UCI), pero en paralelo
+void perft_divide_parallel(const Position *pos, int depth, int threads, PerftTable *tt);
+
+#endif // PERFT_H
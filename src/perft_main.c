@@ -0,0 +1,160 @@
+// chess-perft: benchmark headless de generación de movimientos.
+// Corre perft sobre posiciones conocidas, verifica los conteos y mide nps.
+//
+// Uso: chess-perft [--depth N] [--threads N] [--hash MB] [--json]
+//                  [--fen "<fen>" --depth N] [--divide] [--scalar]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "board.h"
+#include "perft.h"
+#include "clock.h"
+
+#define MAX_KNOWN_DEPTH 7
+
+typedef struct {
+    const char *name;
+    const char *fen;
+    int         depth;                          // profundidad por defecto
+    uint64_t    expected[MAX_KNOWN_DEPTH + 1];  // 0 = desconocido
+} PerftCase;
+
+// Conteos de referencia (chessprogramming.org / suites públicas)
+static const PerftCase SUITE[] = {
+    { "startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+      { 1, 20, 400, 8902, 197281, 4865609, 119060324, 3195901860ULL } },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+      { 1, 48, 2039, 97862, 4085603, 193690690, 8031647685ULL } },
+    { "pos3-ep", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6,
+      { 1, 14, 191, 2812, 43238, 674624, 11030083, 178633661 } },
+    { "pos4-promo", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5,
+      { 1, 6, 264, 9467, 422333, 15833292, 706045033 } },
+    { "pos5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+      { 1, 44, 1486, 62379, 2103487, 89941194 } },
+    { "pos6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+      { 1, 46, 2079, 89890, 3894594, 164075551 } },
+    { "ep-discovered", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6,
+      { 1, 18, 92, 1670, 10138, 185429, 1134888 } },
+    { "ep-pinned", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6,
+      { 1, 15, 126, 1928, 13931, 206379, 1440467 } },
+    { "promo-check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6,
+      { 1, 11, 133, 1442, 19174, 266199, 3821001 } },
+    { "underpromo", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6,
+      { 1, 6, 27, 273, 1329, 18135, 92683 } },
+};
+#define SUITE_SIZE ((int)(sizeof(SUITE) / sizeof(SUITE[0])))
+
+typedef struct {
+    int         depth;     // <= 0: la de cada caso
+    int         threads;
+    int         hashMB;    // 0 = sin tabla
+    int         json;
+    int         divide;
+    int         scalar;    // forzar los rellenos escalares (sin AVX2)
+    const char *fen;       // posición propia en vez de la suite
+} Options;
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Uso: %s [--depth N] [--threads N] [--hash MB] [--json] [--fen \"<fen>\"] [--divide] [--scalar]\n"
+            "  --depth N    profundidad (por defecto, la de cada posición)\n"
+            "  --threads N  hilos (por defecto 1; 0 = todos los núcleos)\n"
+            "  --hash MB    tabla hash de perft (por defecto sin tabla)\n"
+            "  --json       una línea JSON por posición\n"
+            "  --fen F      medir sólo esta posición (sin conteo esperado)\n"
+            "  --divide     conteo por movimiento raíz (con --fen o la posición inicial)\n"
+            "  --scalar     mapas de ataques sin AVX2 (para comparar con el kernel SIMD)\n",
+            argv0);
+}
+
+static int parse_args(int argc, char **argv, Options *o) {
+    *o = (Options){ 0, 1, 0, 0, 0, 0, NULL };
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        int hasVal = (i + 1 < argc);
+        if      (!strcmp(a, "--depth")   && hasVal) o->depth   = atoi(argv[++i]);
+        else if (!strcmp(a, "--threads") && hasVal) o->threads = atoi(argv[++i]);
+        else if (!strcmp(a, "--hash")    && hasVal) o->hashMB  = atoi(argv[++i]);
+        else if (!strcmp(a, "--fen")     && hasVal) o->fen     = argv[++i];
+        else if (!strcmp(a, "--json"))   o->json   = 1;
+        else if (!strcmp(a, "--divide")) o->divide = 1;
+        else if (!strcmp(a, "--scalar")) o->scalar = 1;
+        else { usage(argv[0]); return 0; }
+    }
+    return 1;
+}
+
+// Corre un caso; devuelve 0 si el conteo no coincide con el esperado
+static int run_case(const char *name, const char *fen, int depth, uint64_t expected,
+                    const Options *o, PerftTable *tt) {
+    Position pos;
+    if (!position_from_fen(&pos, fen)) {
+        fprintf(stderr, "FEN inválido: %s\n", fen);
+        return 0;
+    }
+    if (tt) perft_table_clear(tt);
+
+    double t0 = clock_now();
+    uint64_t nodes = perft_parallel(&pos, depth, o->threads, tt);
+    double secs = clock_now() - t0;
+    double nps = secs > 0.0 ? (double)nodes / secs : 0.0;
+    int ok = (expected == 0 || nodes == expected);
+    double hitRate = (tt && tt->probes) ? 100.0 * (double)tt->hits / (double)tt->probes : 0.0;
+
+    if (o->json) {
+        printf("{\"name\":\"%s\",\"fen\":\"%s\",\"depth\":%d,\"nodes\":%llu,\"expected\":%llu,"
+               "\"ok\":%s,\"seconds\":%.6f,\"nps\":%.0f,\"threads\":%d,\"hash_mb\":%d,\"hash_hit_pct\":%.2f}\n",
+               name, fen, depth, (unsigned long long)nodes, (unsigned long long)expected,
+               ok ? "true" : "false", secs, nps, o->threads, o->hashMB, hitRate);
+    } else {
+        printf("%-14s d=%d  nodes=%-12llu %8.3f s  %7.2f Mnps  %s",
+               name, depth, (unsigned long long)nodes, secs, nps / 1e6,
+               expected == 0 ? "(sin referencia)" : (ok ? "OK" : "FALLO"));
+        if (!ok) printf(" (esperado %llu)", (unsigned long long)expected);
+        if (tt) printf("  hash %.1f%%", hitRate);
+        printf("\n");
+    }
+    fflush(stdout);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    Options o;
+    if (!parse_args(argc, argv, &o)) return 2;
+    if (o.threads <= 0) o.threads = perft_default_threads();
+    board_force_scalar(o.scalar);
+
+    PerftTable table, *tt = NULL;
+    if (o.hashMB > 0) {
+        if (!perft_table_init(&table, (size_t)o.hashMB)) { fprintf(stderr, "Sin memoria para la tabla hash\n"); return 2; }
+        tt = &table;
+    }
+
+    int failures = 0;
+    if (o.divide) {
+        Position pos;
+        const char *fen = o.fen ? o.fen : SUITE[0].fen;
+        if (!position_from_fen(&pos, fen)) { fprintf(stderr, "FEN inválido: %s\n", fen); return 2; }
+        perft_divide_parallel(&pos, o.depth > 0 ? o.depth : 1, o.threads, tt);
+    } else if (o.fen) {
+        failures += !run_case("fen", o.fen, o.depth > 0 ? o.depth : 1, 0, &o, tt);
+    } else {
+        double t0 = clock_now();
+        for (int i = 0; i < SUITE_SIZE; ++i) {
+            const PerftCase *c = &SUITE[i];
+            int depth = o.depth > 0 ? o.depth : c->depth;
+            uint64_t expected = depth <= MAX_KNOWN_DEPTH ? c->expected[depth] : 0;
+            failures += !run_case(c->name, c->fen, depth, expected, &o, tt);
+        }
+        double secs = clock_now() - t0;
+        if (o.json) {
+            printf("{\"summary\":true,\"positions\":%d,\"failures\":%d,\"seconds\":%.6f,\"threads\":%d,\"hash_mb\":%d,\"kernel\":\"%s\"}\n",
+                   SUITE_SIZE, failures, secs, o.threads, o.hashMB, board_slider_kernel());
+        } else {
+            printf("Total: %d posiciones, %d fallos, %.3f s (ataques: %s)\n", SUITE_SIZE, failures, secs, board_slider_kernel());
+        }
+    }
+
+    if (tt) perft_table_free(tt);
+    return failures ? 1 : 0;
+}
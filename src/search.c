@@ -0,0 +1,479 @@
+#include "search.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clock.h"
+
+/* ---------------- Evaluación ----------------
+ * Material + tablas por casilla (las "simplified evaluation" clásicas).
+ * Las tablas están escritas como se ve el tablero: primera fila = fila 8,
+ * desde el lado de blancas. Una pieza blanca en 'sq' usa [sq ^ 56] y una
+ * negra usa [sq] (queda espejada).
+ */
+static const int PIECE_VALUE[6] = { 100, 320, 330, 500, 900, 0 };
+static const int PHASE_WEIGHT[6] = { 0, 1, 1, 2, 4, 0 };   // 24 = apertura completa
+
+static const int8_t PST[5][64] = {
+    { // peón
+       0,  0,  0,  0,  0,  0,  0,  0,
+      50, 50, 50, 50, 50, 50, 50, 50,
+      10, 10, 20, 30, 30, 20, 10, 10,
+       5,  5, 10, 25, 25, 10,  5,  5,
+       0,  0,  0, 20, 20,  0,  0,  0,
+       5, -5,-10,  0,  0,-10, -5,  5,
+       5, 10, 10,-20,-20, 10, 10,  5,
+       0,  0,  0,  0,  0,  0,  0,  0 },
+    { // caballo
+     -50,-40,-30,-30,-30,-30,-40,-50,
+     -40,-20,  0,  0,  0,  0,-20,-40,
+     -30,  0, 10, 15, 15, 10,  0,-30,
+     -30,  5, 15, 20, 20, 15,  5,-30,
+     -30,  0, 15, 20, 20, 15,  0,-30,
+     -30,  5, 10, 15, 15, 10,  5,-30,
+     -40,-20,  0,  5,  5,  0,-20,-40,
+     -50,-40,-30,-30,-30,-30,-40,-50 },
+    { // alfil
+     -20,-10,-10,-10,-10,-10,-10,-20,
+     -10,  0,  0,  0,  0,  0,  0,-10,
+     -10,  0,  5, 10, 10,  5,  0,-10,
+     -10,  5,  5, 10, 10,  5,  5,-10,
+     -10,  0, 10, 10, 10, 10,  0,-10,
+     -10, 10, 10, 10, 10, 10, 10,-10,
+     -10,  5,  0,  0,  0,  0,  5,-10,
+     -20,-10,-10,-10,-10,-10,-10,-20 },
+    { // torre
+       0,  0,  0,  0,  0,  0,  0,  0,
+       5, 10, 10, 10, 10, 10, 10,  5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+      -5,  0,  0,  0,  0,  0,  0, -5,
+       0,  0,  0,  5,  5,  0,  0,  0 },
+    { // dama
+     -20,-10,-10, -5, -5,-10,-10,-20,
+     -10,  0,  0,  0,  0,  0,  0,-10,
+     -10,  0,  5,  5,  5,  5,  0,-10,
+      -5,  0,  5,  5,  5,  5,  0, -5,
+       0,  0,  5,  5,  5,  5,  0, -5,
+     -10,  5,  5,  5,  5,  5,  0,-10,
+     -10,  0,  5,  0,  0,  0,  0,-10,
+     -20,-10,-10, -5, -5,-10,-10,-20 },
+};
+
+// Rey: medio juego (refugio) y final (centralizar); se mezclan según la fase
+static const int8_t PST_KING_MG[64] = {
+     -30,-40,-40,-50,-50,-40,-40,-30,
+     -30,-40,-40,-50,-50,-40,-40,-30,
+     -30,-40,-40,-50,-50,-40,-40,-30,
+     -30,-40,-40,-50,-50,-40,-40,-30,
+     -20,-30,-30,-40,-40,-30,-30,-20,
+     -10,-20,-20,-20,-20,-20,-20,-10,
+      20, 20,  0,  0,  0,  0, 20, 20,
+      20, 30, 10,  0,  0, 10, 30, 20 };
+static const int8_t PST_KING_EG[64] = {
+     -50,-40,-30,-20,-20,-30,-40,-50,
+     -30,-20,-10,  0,  0,-10,-20,-30,
+     -30,-10, 20, 30, 30, 20,-10,-30,
+     -30,-10, 30, 40, 40, 30,-10,-30,
+     -30,-10, 30, 40, 40, 30,-10,-30,
+     -30,-10, 20, 30, 30, 20,-10,-30,
+     -30,-30,  0,  0,  0,  0,-30,-30,
+     -50,-30,-30,-30,-30,-30,-30,-50 };
+
+int evaluate(const Position *pos) {
+    int score = 0, phase = 0; // desde blancas
+    for (int pt = 0; pt < 5; ++pt) {
+        uint64_t w = pos->bb[WP + pt], b = pos->bb[BP + pt];
+        phase += PHASE_WEIGHT[pt] * (__builtin_popcountll(w) + __builtin_popcountll(b));
+        while (w) { int sq = __builtin_ctzll(w); w &= w - 1; score += PIECE_VALUE[pt] + PST[pt][sq ^ 56]; }
+        while (b) { int sq = __builtin_ctzll(b); b &= b - 1; score -= PIECE_VALUE[pt] + PST[pt][sq]; }
+    }
+    if (phase > 24) phase = 24;
+
+    if (pos->bb[WK] && pos->bb[BK]) {
+        int wk = __builtin_ctzll(pos->bb[WK]) ^ 56, bk = __builtin_ctzll(pos->bb[BK]);
+        int mg = PST_KING_MG[wk] - PST_KING_MG[bk];
+        int eg = PST_KING_EG[wk] - PST_KING_EG[bk];
+        score += (mg * phase + eg * (24 - phase)) / 24;
+    }
+    return pos->side == 1 ? score : -score;
+}
+
+/* ---------------- Estado de una búsqueda ---------------- */
+#define HISTORY_KEYS 100   // más atrás que la regla de 50 no se puede repetir
+
+typedef struct SearchContext SearchContext;
+
+// Lo que comparten todos los hilos de una búsqueda
+typedef struct {
+    int            stopAll;     // el hilo principal terminó: cortar todos
+    SearchContext *threads;     // [0] = principal, resto ayudantes
+    int            nthreads;
+} SearchShared;
+
+struct SearchContext {
+    Position           *pos;
+    Position            rootCopy;        // posición propia (ayudantes)
+    const SearchLimits *limits;
+    TransTable         *tt;
+    SearchShared       *shared;
+    int                 id;              // 0 = hilo principal
+    pthread_t           thread;
+    double              start;
+    double              deadline;        // 0 = sin tiempo límite
+    uint64_t            nodes;
+    uint64_t            published;       // copia de 'nodes' que leen los demás
+    uint64_t            helperNodes;     // (principal) suma de los ayudantes
+    int                 seldepth;
+    int                 stopped;
+
+    // PV triangular: pv[ply] es la variante desde ese ply
+    Move                pv[MAX_PLY][MAX_PLY];
+    int                 pvLen[MAX_PLY];
+    Move                prevPv[MAX_PLY]; // PV de la iteración anterior
+    int                 prevPvLen;
+    int                 followPv;        // seguimos en la PV anterior
+
+    Move                killers[MAX_PLY][2];
+    int                 history[12][64];
+
+    // claves para repeticiones: partida previa + camino actual
+    uint64_t            keys[HISTORY_KEYS + MAX_PLY + 1];
+    int                 keyBase;         // índice de la raíz en keys
+};
+
+static uint64_t helper_nodes(const SearchShared *sh) {
+    uint64_t n = 0;
+    for (int i = 1; i < sh->nthreads; ++i) n += __atomic_load_n(&sh->threads[i].published, __ATOMIC_RELAXED);
+    return n;
+}
+
+// Los límites los controla el principal; los ayudantes sólo miran stopAll
+static void check_limits(SearchContext *ctx) {
+    const SearchLimits *lim = ctx->limits;
+    if (ctx->id == 0 && lim->maxNodes && ctx->nodes + ctx->helperNodes >= lim->maxNodes) ctx->stopped = 1;
+    if ((ctx->nodes & 1023) == 0) {
+        __atomic_store_n(&ctx->published, ctx->nodes, __ATOMIC_RELAXED);
+        if (__atomic_load_n(&ctx->shared->stopAll, __ATOMIC_RELAXED)) ctx->stopped = 1;
+        if (ctx->id == 0) {
+            if (lim->stop && __atomic_load_n(lim->stop, __ATOMIC_RELAXED)) ctx->stopped = 1;
+            if (ctx->deadline > 0.0 && clock_now() >= ctx->deadline) ctx->stopped = 1;
+            if (ctx->shared->nthreads > 1) ctx->helperNodes = helper_nodes(ctx->shared);
+        }
+    }
+}
+
+static int is_repetition(const SearchContext *ctx, int ply) {
+    int cur = ctx->keyBase + ply;
+    int limit = cur - ctx->pos->halfmove;
+    if (limit < 0) limit = 0;
+    for (int i = cur - 4; i >= limit; i -= 2)
+        if (ctx->keys[i] == ctx->keys[cur]) return 1;
+    return 0;
+}
+
+/* ---------------- Orden de jugadas ----------------
+ * PV anterior (o jugada de la TT) > capturas y promociones (MVV-LVA) > killers > historia.
+ */
+#define ORDER_PV      (1 << 30)
+#define ORDER_CAPTURE (1 << 24)
+#define ORDER_KILLER  (1 << 22)
+
+static void score_moves(const SearchContext *ctx, const MoveList *list, int scores[], int ply, Move pvMove) {
+    const int8_t *mb = ctx->pos->mailbox;
+    for (int i = 0; i < list->count; ++i) {
+        Move m = list->moves[i];
+        int from = move_from(m), to = move_to(m);
+        int attacker = mb[from];
+        if (m == pvMove) scores[i] = ORDER_PV;
+        else if (move_is_capture(m) || move_is_promo(m)) {
+            int s = ORDER_CAPTURE;
+            if (move_is_capture(m)) {
+                int victim = move_flags(m) == MF_EP ? 0 : mb[to] % 6;
+                s += PIECE_VALUE[victim] * 16 - PIECE_VALUE[attacker % 6] / 16;
+            }
+            if (move_is_promo(m)) s += PIECE_VALUE[(move_flags(m) & 3) + 1];
+            scores[i] = s;
+        }
+        else if (m == ctx->killers[ply][0]) scores[i] = ORDER_KILLER + 1;
+        else if (m == ctx->killers[ply][1]) scores[i] = ORDER_KILLER;
+        else scores[i] = ctx->history[attacker][to];
+    }
+}
+
+// Trae al índice 'i' la de mayor puntaje entre las que faltan
+static void pick_move(MoveList *list, int scores[], int i) {
+    int best = i;
+    for (int j = i + 1; j < list->count; ++j)
+        if (scores[j] > scores[best]) best = j;
+    if (best != i) {
+        Move m = list->moves[i]; list->moves[i] = list->moves[best]; list->moves[best] = m;
+        int s = scores[i]; scores[i] = scores[best]; scores[best] = s;
+    }
+}
+
+/* ---------------- Quiescence ----------------
+ * Sólo capturas y promociones (todas las evasiones si hay jaque), para no
+ * evaluar en medio de un cambio.
+ */
+static int quiesce(SearchContext *ctx, int alpha, int beta, int ply) {
+    Position *pos = ctx->pos;
+    ctx->nodes++;
+    check_limits(ctx);
+    if (ctx->stopped) return 0;
+    if (ply > ctx->seldepth) ctx->seldepth = ply;
+
+    int inCheck = is_king_in_check(pos, pos->side);
+    MoveList list;
+    gen_legal_moves(pos, &list);
+    if (list.count == 0) return inCheck ? -SCORE_MATE + ply : 0;
+    if (ply >= MAX_PLY - 1) return evaluate(pos);
+
+    int best = -SCORE_INF;
+    if (!inCheck) {
+        best = evaluate(pos);
+        if (best >= beta) return best;
+        if (best > alpha) alpha = best;
+    }
+
+    int scores[MAX_MOVES];
+    score_moves(ctx, &list, scores, ply, MOVE_NONE);
+    for (int i = 0; i < list.count; ++i) {
+        pick_move(&list, scores, i);
+        Move m = list.moves[i];
+        if (!inCheck && !move_is_capture(m) && !move_is_promo(m)) break; // el resto son quietas
+
+        Undo u;
+        move_make(pos, m, &u);
+        int score = -quiesce(ctx, -beta, -alpha, ply + 1);
+        move_unmake(pos, m, &u);
+        if (ctx->stopped) return 0;
+
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+    return best;
+}
+
+/* ---------------- Negamax alfa-beta (PVS) ---------------- */
+static int negamax(SearchContext *ctx, int depth, int alpha, int beta, int ply) {
+    Position *pos = ctx->pos;
+    ctx->pvLen[ply] = 0;
+    if (depth <= 0) { ctx->followPv = 0; return quiesce(ctx, alpha, beta, ply); }
+
+    ctx->nodes++;
+    check_limits(ctx);
+    if (ctx->stopped) return 0;
+    if (ply > ctx->seldepth) ctx->seldepth = ply;
+
+    if (ply > 0) {
+        if (pos->halfmove >= 100 || is_repetition(ctx, ply)) return 0;
+        // mate más corto ya asegurado: no hace falta seguir
+        if (alpha < -SCORE_MATE + ply) alpha = -SCORE_MATE + ply;
+        if (beta > SCORE_MATE - ply - 1) beta = SCORE_MATE - ply - 1;
+        if (alpha >= beta) return alpha;
+    }
+    if (ply >= MAX_PLY - 1) return evaluate(pos);
+
+    // TT: corte directo fuera de la PV (en la PV cortaría la variante)
+    int pvNode = beta - alpha > 1;
+    int origAlpha = alpha;
+    Move ttMove = MOVE_NONE;
+    TTHit hit;
+    if (ctx->tt && tt_probe(ctx->tt, pos->key, ply, &hit)) {
+        ttMove = hit.move;
+        if (!pvNode && ply > 0 && hit.depth >= depth &&
+            (hit.bound == TT_EXACT ||
+             (hit.bound == TT_LOWER && hit.score >= beta) ||
+             (hit.bound == TT_UPPER && hit.score <= alpha)))
+            return hit.score;
+    }
+
+    int inCheck = is_king_in_check(pos, pos->side);
+    if (inCheck) depth++; // extensión de jaque
+
+    MoveList list;
+    gen_legal_moves(pos, &list);
+    if (list.count == 0) return inCheck ? -SCORE_MATE + ply : 0;
+
+    Move pvMove = MOVE_NONE;
+    if (ctx->followPv) {
+        if (ply < ctx->prevPvLen) pvMove = ctx->prevPv[ply];
+        else ctx->followPv = 0;
+    }
+    int scores[MAX_MOVES];
+    score_moves(ctx, &list, scores, ply, pvMove != MOVE_NONE ? pvMove : ttMove);
+
+    int best = -SCORE_INF;
+    Move bestMove = MOVE_NONE;
+    for (int i = 0; i < list.count; ++i) {
+        pick_move(&list, scores, i);
+        Move m = list.moves[i];
+        if (i > 0) ctx->followPv = 0; // la PV anterior sólo guía la primera rama
+
+        Undo u;
+        move_make(pos, m, &u);
+        ctx->keys[ctx->keyBase + ply + 1] = pos->key;
+        int score;
+        if (i == 0) {
+            score = -negamax(ctx, depth - 1, -beta, -alpha, ply + 1);
+        } else {
+            // ventana nula: sólo probamos que no mejora; si mejora, de nuevo completo
+            score = -negamax(ctx, depth - 1, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && score < beta)
+                score = -negamax(ctx, depth - 1, -beta, -alpha, ply + 1);
+        }
+        move_unmake(pos, m, &u);
+        if (ctx->stopped) return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = m;
+            if (score > alpha) {
+                alpha = score;
+                ctx->pv[ply][0] = m;
+                memcpy(&ctx->pv[ply][1], ctx->pv[ply + 1], sizeof(Move) * ctx->pvLen[ply + 1]);
+                ctx->pvLen[ply] = ctx->pvLen[ply + 1] + 1;
+
+                if (alpha >= beta) {
+                    if (!move_is_capture(m) && !move_is_promo(m)) {
+                        if (ctx->killers[ply][0] != m) {
+                            ctx->killers[ply][1] = ctx->killers[ply][0];
+                            ctx->killers[ply][0] = m;
+                        }
+                        int *h = &ctx->history[pos->mailbox[move_from(m)]][move_to(m)];
+                        *h += depth * depth;
+                        if (*h >= ORDER_KILLER) { // que no pase a los killers
+                            for (int p = 0; p < 12; ++p)
+                                for (int s = 0; s < 64; ++s) ctx->history[p][s] /= 2;
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    if (ctx->tt) {
+        int bound = best >= beta ? TT_LOWER : (best > origAlpha ? TT_EXACT : TT_UPPER);
+        tt_store(ctx->tt, pos->key, bestMove, best, depth, bound, ply);
+    }
+    return best;
+}
+
+/* ---------------- Profundización iterativa ---------------- */
+static const SearchLimits NO_LIMITS;
+
+static int depth_limit(const SearchLimits *lim) {
+    return (lim->maxDepth <= 0 || lim->maxDepth > MAX_PLY - 1) ? MAX_PLY - 1 : lim->maxDepth;
+}
+
+// Claves de la partida que todavía se pueden repetir (desde la última
+// jugada irreversible) + la raíz
+static void init_keys(SearchContext *ctx) {
+    const SearchLimits *lim = ctx->limits;
+    int n = lim->history ? lim->historyLen : 0;
+    if (n > ctx->pos->halfmove) n = ctx->pos->halfmove;
+    if (n > HISTORY_KEYS) n = HISTORY_KEYS;
+    if (n > 0) memcpy(ctx->keys, lim->history + lim->historyLen - n, sizeof(uint64_t) * n);
+    ctx->keyBase = n;
+    ctx->keys[n] = ctx->pos->key;
+}
+
+// Ayudante de Lazy SMP: misma búsqueda sobre su copia; los impares arrancan
+// un ply más adelante para no ir a la par del principal. Lo que encuentran
+// le llega al principal por la TT.
+static void *helper_main(void *arg) {
+    SearchContext *ctx = (SearchContext*)arg;
+    int maxDepth = depth_limit(ctx->limits);
+    for (int depth = 1 + (ctx->id & 1); depth <= maxDepth && !ctx->stopped; ++depth)
+        negamax(ctx, depth, -SCORE_INF, SCORE_INF, 0);
+    __atomic_store_n(&ctx->published, ctx->nodes, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+Move search_best_move(Position *pos, const SearchLimits *limits, SearchInfo *info) {
+    SearchInfo local;
+    SearchInfo *out = info ? info : &local;
+    memset(out, 0, sizeof(*out));
+
+    MoveList root;
+    gen_legal_moves(pos, &root);
+    if (root.count == 0) return MOVE_NONE;
+
+    if (!limits) limits = &NO_LIMITS;
+    int nthreads = (limits->tt && limits->threads > 1) ? limits->threads : 1;
+
+    // Los contextos son grandes (PV triangular): al heap, no al stack del hilo
+    SearchContext *ctxs = (SearchContext*)calloc((size_t)nthreads, sizeof(SearchContext));
+    if (!ctxs) return root.moves[0];
+    SearchShared shared = { 0, ctxs, 1 };
+
+    double start = clock_now();
+    if (limits->tt) tt_new_search(limits->tt);
+    for (int i = 0; i < nthreads; ++i) {
+        SearchContext *c = &ctxs[i];
+        c->id = i;
+        c->shared = &shared;
+        c->limits = limits;
+        c->tt = limits->tt;
+        c->start = start;
+        if (i > 0) c->rootCopy = *pos;
+        c->pos = i == 0 ? pos : &c->rootCopy;
+        init_keys(c);
+    }
+    SearchContext *ctx = &ctxs[0];
+    if (limits->maxTimeMs > 0) ctx->deadline = start + limits->maxTimeMs / 1000.0;
+
+    for (int i = 1; i < nthreads; ++i) {
+        if (pthread_create(&ctxs[i].thread, NULL, helper_main, &ctxs[i]) != 0) break;
+        shared.nthreads = i + 1;
+    }
+
+    int maxDepth = depth_limit(limits);
+    Move best = root.moves[0];
+    out->pv[0] = best;
+    out->pvLength = 1;
+
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        ctx->followPv = 1;
+        ctx->seldepth = 0;
+        int score = negamax(ctx, depth, -SCORE_INF, SCORE_INF, 0);
+        double secs = clock_now() - start;
+        out->nodes = ctx->nodes + helper_nodes(&shared);
+        out->seconds = secs;
+        out->nps = secs > 0.0 ? (uint64_t)((double)out->nodes / secs) : 0;
+        out->hashfull = limits->tt ? tt_hashfull(limits->tt) : 0;
+        if (ctx->stopped) break; // iteración incompleta: nos quedamos con la anterior
+
+        out->depth = depth;
+        out->seldepth = ctx->seldepth;
+        out->score = score;
+        out->pvLength = ctx->pvLen[0];
+        memcpy(out->pv, ctx->pv[0], sizeof(Move) * ctx->pvLen[0]);
+        memcpy(ctx->prevPv, ctx->pv[0], sizeof(Move) * ctx->pvLen[0]);
+        ctx->prevPvLen = ctx->pvLen[0];
+        if (ctx->pvLen[0] > 0) best = ctx->pv[0][0];
+
+        if (limits->onIteration) limits->onIteration(out, limits->user);
+
+        // mate encontrado dentro del horizonte: más profundidad no lo cambia
+        if (score_is_mate(score) && SCORE_MATE - (score < 0 ? -score : score) <= depth) break;
+        // no empezar una iteración que casi seguro no termina
+        if (ctx->deadline > 0.0 && clock_now() - start > (ctx->deadline - start) * 0.5) break;
+    }
+
+    __atomic_store_n(&shared.stopAll, 1, __ATOMIC_RELAXED);
+    for (int i = 1; i < shared.nthreads; ++i) pthread_join(ctxs[i].thread, NULL);
+    out->nodes = ctx->nodes + helper_nodes(&shared);
+    if (out->seconds > 0.0) out->nps = (uint64_t)((double)out->nodes / out->seconds);
+
+    free(ctxs);
+    return best;
+}
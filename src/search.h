@@ -0,0 +1,64 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+#include "board.h"
+#include "tt.h"
+
+// ----- Búsqueda alfa-beta (negamax) con profundización iterativa -----
+// Puntajes en centipeones desde el bando que mueve. Un mate en n ply vale
+// SCORE_MATE - n (o -(SCORE_MATE - n) si lo recibimos).
+
+#define MAX_PLY     128
+#define SCORE_INF   32001
+#define SCORE_MATE  32000
+#define SCORE_MATE_BOUND (SCORE_MATE - MAX_PLY)   // |score| >= esto => mate
+
+static inline int score_is_mate(int score) {
+    return score >= SCORE_MATE_BOUND || score <= -SCORE_MATE_BOUND;
+}
+// Jugadas (no ply) hasta el mate: >0 damos mate, <0 nos lo dan
+static inline int score_mate_in(int score) {
+    return score > 0 ? (SCORE_MATE - score + 1) / 2 : -(SCORE_MATE + score) / 2;
+}
+
+// Resultado de una iteración completa (y de la búsqueda entera)
+typedef struct {
+    int      depth;            // profundidad de la última iteración completa
+    int      seldepth;         // ply máximo alcanzado (quiescence incluida)
+    int      score;
+    uint64_t nodes;
+    double   seconds;
+    uint64_t nps;
+    int      hashfull;         // permil de la TT usado (0 sin TT)
+    Move     pv[MAX_PLY];
+    int      pvLength;
+} SearchInfo;
+
+typedef void (*SearchCallback)(const SearchInfo *info, void *user);
+
+// Límites: 0 = sin límite. Se corta con el primero que se cumpla.
+// 'stop' (opcional) lo puede poner en 1 otro hilo para abortar.
+// Con 'tt' y threads > 1 corre Lazy SMP: los ayudantes buscan la misma
+// posición sobre la TT compartida y el hilo que llama decide la jugada.
+typedef struct {
+    int             maxDepth;      // 0 = hasta MAX_PLY
+    uint64_t        maxNodes;
+    int             maxTimeMs;
+    volatile int   *stop;
+    const uint64_t *history;       // claves de la partida antes de 'pos' (repeticiones)
+    int             historyLen;
+    TransTable     *tt;            // opcional; sin TT se usa un solo hilo
+    int             threads;       // <= 1: sólo el hilo que llama
+    SearchCallback  onIteration;   // se llama tras cada iteración completa
+    void           *user;
+} SearchLimits;
+
+// Evaluación estática (material + tablas por casilla), desde el bando que mueve
+int evaluate(const Position *pos);
+
+// Busca desde 'pos' (se usa como espacio de trabajo y se devuelve intacta).
+// Devuelve la mejor jugada de la última iteración completa (o, si ni la
+// primera terminó, la primera legal); MOVE_NONE si no hay jugadas legales.
+// 'info' es opcional.
+Move search_best_move(Position *pos, const SearchLimits *limits, SearchInfo *info);
+
+#endif // SEARCH_H
@@ -0,0 +1,60 @@
+#ifndef SPSC_H
+#define SPSC_H
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ----- Cola lock-free de un productor y un consumidor -----
+// Anillo de tamaño fijo (potencia de 2) con elementos de tamaño fijo. El
+// productor sólo escribe 'tail' y el consumidor sólo 'head'; cada uno publica
+// con release y lee el índice del otro con acquire, así que nunca se bloquea.
+// Los índices van en líneas de caché separadas para que no se peleen.
+
+typedef struct {
+    unsigned char *buf;
+    size_t         elemSize;
+    uint32_t       mask;
+    char           pad0[64];
+    uint32_t       head;       // próximo a leer (consumidor)
+    char           pad1[64];
+    uint32_t       tail;       // próximo a escribir (productor)
+    char           pad2[64];
+} SpscQueue;
+
+// capacity se redondea a potencia de 2. Devuelve 1 si pudo reservar.
+static inline int spsc_init(SpscQueue *q, size_t elemSize, uint32_t capacity) {
+    uint32_t n = 1;
+    while (n < capacity) n *= 2;
+    memset(q, 0, sizeof(*q));
+    q->buf = (unsigned char*)malloc(elemSize * n);
+    q->elemSize = elemSize;
+    q->mask = n - 1;
+    return q->buf != NULL;
+}
+
+static inline void spsc_free(SpscQueue *q) {
+    free(q->buf);
+    q->buf = NULL;
+}
+
+// Productor: 0 si está llena (no espera)
+static inline int spsc_push(SpscQueue *q, const void *item) {
+    uint32_t tail = q->tail;
+    uint32_t head = __atomic_load_n(&q->head, __ATOMIC_ACQUIRE);
+    if (tail - head > q->mask) return 0;
+    memcpy(q->buf + (size_t)(tail & q->mask) * q->elemSize, item, q->elemSize);
+    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Consumidor: 0 si está vacía (no espera)
+static inline int spsc_pop(SpscQueue *q, void *item) {
+    uint32_t head = q->head;
+    uint32_t tail = __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
+    if (head == tail) return 0;
+    memcpy(item, q->buf + (size_t)(head & q->mask) * q->elemSize, q->elemSize);
+    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+#endif // SPSC_H
@@ -0,0 +1,32 @@
+#ifndef STATS_H
+#define STATS_H
+#include <stdint.h>
+
+// ----- Contadores de instrumentación (CHESS_STATS) -----
+// Cuentan llamadas en el camino caliente para ver regresiones sin perfilador.
+// Son por hilo (sin atomics ni líneas compartidas): cada hilo lee y reinicia
+// los suyos con chess_stats_take. Sin CHESS_STATS, STAT_INC no genera nada.
+
+typedef struct {
+    uint64_t makes;          // move_make
+    uint64_t legalGens;      // generaciones legales (gen_legal_moves, _from, move_find)
+    uint64_t legalFrom;      // gen_legal_moves_from (destinos de una pieza)
+    uint64_t attackQueries;  // is_square_attacked_by_side / is_king_in_check / attacked_squares
+    uint64_t attackMaps;     // mapas de ataques calculados (rellenos de deslizantes)
+    uint64_t sliderLookups;  // ataques de alfil/torre leídos de las tablas
+    uint64_t ttProbes;       // consultas a la TT
+    uint64_t ttHits;         // ... que encontraron la posición
+} ChessStats;
+
+#ifdef CHESS_STATS
+extern __thread ChessStats gChessStats;
+#define STAT_INC(field) ((void)gChessStats.field++)
+#else
+#define STAT_INC(field) ((void)0)
+#endif
+
+// Copia los contadores del hilo actual a 'out' (ceros sin CHESS_STATS) y los
+// reinicia. Devuelve 1 si la instrumentación está compilada.
+int chess_stats_take(ChessStats *out);
+
+#endif // STATS_H
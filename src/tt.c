@@ -0,0 +1,152 @@
+#include "tt.h"
+#include "search.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/* ---------------- Empaquetado ---------------- */
+static inline uint64_t tt_pack(Move move, int score, int depth, int bound, int age) {
+    return (uint64_t)move
+         | (uint64_t)(uint16_t)(int16_t)score << 16
+         | (uint64_t)(uint8_t)depth << 32
+         | (uint64_t)(bound & 3) << 40
+         | (uint64_t)(age & 63) << 42;
+}
+static inline Move tt_move(uint64_t d)  { return (Move)(d & 0xFFFF); }
+static inline int  tt_score(uint64_t d) { return (int16_t)(uint16_t)(d >> 16); }
+static inline int  tt_depth(uint64_t d) { return (int)(uint8_t)(d >> 32); }
+static inline int  tt_bound(uint64_t d) { return (int)(d >> 40) & 3; }
+static inline int  tt_age(uint64_t d)   { return (int)(d >> 42) & 63; }
+
+// Los mates se guardan "desde el nodo" para que valgan en cualquier camino
+static inline int score_to_tt(int score, int ply) {
+    if (score >= SCORE_MATE_BOUND)  return score + ply;
+    if (score <= -SCORE_MATE_BOUND) return score - ply;
+    return score;
+}
+static inline int score_from_tt(int score, int ply) {
+    if (score >= SCORE_MATE_BOUND)  return score - ply;
+    if (score <= -SCORE_MATE_BOUND) return score + ply;
+    return score;
+}
+
+// Lecturas/escrituras atómicas de 64 bits sin orden: la consistencia la da
+// check = key ^ data, no el orden de memoria.
+static inline uint64_t load64(const uint64_t *p)      { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+static inline void     store64(uint64_t *p, uint64_t v) { __atomic_store_n(p, v, __ATOMIC_RELAXED); }
+
+/* ---------------- Reserva ---------------- */
+#define HUGE_PAGE (2u * 1024 * 1024)
+
+int tt_init(TransTable *tt, size_t megabytes, int hugePages) {
+    size_t bytes = megabytes * 1024 * 1024;
+    uint64_t n = 1;
+    while (n * 2 * TT_BUCKET * sizeof(TTEntry) <= bytes) n *= 2;
+    bytes = n * TT_BUCKET * sizeof(TTEntry);
+
+    memset(tt, 0, sizeof(*tt));
+    void *mem = NULL;
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    // páginas enormes reservadas por el sistema (vm.nr_hugepages)
+    if (hugePages && bytes % HUGE_PAGE == 0) {
+        mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem == MAP_FAILED) mem = NULL;
+        else tt->mapped = 1;
+    }
+#endif
+    if (!mem) {
+        // alineado a línea de caché (o a página enorme, para THP)
+        size_t align = (hugePages && bytes >= HUGE_PAGE) ? HUGE_PAGE : 64;
+        if (posix_memalign(&mem, align, bytes) != 0) return 0;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (hugePages) madvise(mem, bytes, MADV_HUGEPAGE);
+#endif
+    }
+
+    tt->entries = (TTEntry*)mem;
+    tt->mask = n - 1;
+    tt->bytes = bytes;
+    tt_clear(tt);
+    return 1;
+}
+
+void tt_clear(TransTable *tt) {
+    memset(tt->entries, 0, tt->bytes);
+    tt->age = 0;
+}
+
+void tt_free(TransTable *tt) {
+#if defined(__linux__)
+    if (tt->mapped) munmap(tt->entries, tt->bytes);
+    else
+#endif
+    free(tt->entries);
+    memset(tt, 0, sizeof(*tt));
+}
+
+void tt_new_search(TransTable *tt) {
+    tt->age = (uint8_t)((tt->age + 1) & 63);
+}
+
+/* ---------------- Consulta / guardado ---------------- */
+static inline TTEntry *tt_bucket(const TransTable *tt, uint64_t key) {
+    return &tt->entries[(key & tt->mask) * TT_BUCKET];
+}
+
+int tt_probe(const TransTable *tt, uint64_t key, int ply, TTHit *out) {
+    TTEntry *e = tt_bucket(tt, key);
+    STAT_INC(ttProbes);
+    for (int i = 0; i < TT_BUCKET; ++i) {
+        uint64_t data = load64(&e[i].data);
+        if ((load64(&e[i].check) ^ data) != key || tt_bound(data) == TT_NONE) continue;
+        STAT_INC(ttHits);
+        out->move  = tt_move(data);
+        out->score = score_from_tt(tt_score(data), ply);
+        out->depth = tt_depth(data);
+        out->bound = tt_bound(data);
+        return 1;
+    }
+    return 0;
+}
+
+void tt_store(TransTable *tt, uint64_t key, Move move, int score, int depth, int bound, int ply) {
+    TTEntry *e = tt_bucket(tt, key);
+    int age = tt->age;
+
+    // Misma posición si está; si no, la menos valiosa (vieja y poco profunda)
+    TTEntry *slot = NULL;
+    int worst = 1 << 30, found = 0;
+    uint64_t old = 0;
+    for (int i = 0; i < TT_BUCKET; ++i) {
+        uint64_t data = load64(&e[i].data);
+        if ((load64(&e[i].check) ^ data) == key) { slot = &e[i]; old = data; found = 1; break; }
+        int value = tt_depth(data) - 8 * ((age - tt_age(data)) & 63);
+        if (tt_bound(data) == TT_NONE) value = -(1 << 20);
+        if (value < worst) { worst = value; slot = &e[i]; }
+    }
+
+    if (found) {
+        // no pisar un resultado más profundo de esta misma búsqueda con uno pobre
+        if (bound != TT_EXACT && depth + 3 < tt_depth(old) && tt_age(old) == age) return;
+        if (move == MOVE_NONE) move = tt_move(old);
+    }
+
+    if (depth < 0) depth = 0;
+    if (depth > 255) depth = 255;
+    uint64_t data = tt_pack(move, score_to_tt(score, ply), depth, bound, age);
+    store64(&slot->check, key ^ data);
+    store64(&slot->data, data);
+}
+
+int tt_hashfull(const TransTable *tt) {
+    uint64_t n = (tt->mask + 1) * TT_BUCKET;
+    int sample = n < 1000 ? (int)n : 1000, used = 0;
+    for (int i = 0; i < sample; ++i) {
+        uint64_t data = load64(&tt->entries[i].data);
+        if (tt_bound(data) != TT_NONE && tt_age(data) == tt->age) used++;
+    }
+    return sample ? used * 1000 / sample : 0;
+}
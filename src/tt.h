@@ -0,0 +1,52 @@
+#ifndef TT_H
+#define TT_H
+#include "board.h"
+
+// ----- Tabla de transposición compartida (sin locks) -----
+// Entradas de 16 bytes, en grupos de 4 (una línea de caché). Cada entrada se
+// escribe como check = key ^ data: si dos hilos escriben a la vez y una
+// lectura mezcla mitades de cada uno, la verificación falla y se ignora.
+
+enum { TT_NONE = 0, TT_UPPER = 1, TT_LOWER = 2, TT_EXACT = 3 };
+
+typedef struct {
+    uint64_t check;    // key ^ data
+    uint64_t data;     // move 16 | score 16 | depth 8 | bound 2 | age 6
+} TTEntry;
+
+#define TT_BUCKET 4
+
+typedef struct {
+    TTEntry *entries;
+    uint64_t mask;        // nº de grupos - 1 (potencia de 2)
+    size_t   bytes;
+    int      mapped;      // 1 = reservado con mmap (páginas enormes)
+    uint8_t  age;         // sube en cada búsqueda nueva
+} TransTable;
+
+// Lo que devuelve una consulta
+typedef struct {
+    Move move;
+    int  score;           // ya corregido por ply si es mate
+    int  depth;
+    int  bound;
+} TTHit;
+
+// Reserva la mayor potencia de 2 de grupos que entra en 'megabytes'.
+// hugePages: intenta páginas enormes (Linux); si no hay, sigue con normales.
+// Devuelve 1 si pudo, 0 si no.
+int  tt_init(TransTable *tt, size_t megabytes, int hugePages);
+void tt_clear(TransTable *tt);
+void tt_free(TransTable *tt);
+
+// Marca el inicio de una búsqueda: las entradas viejas se reemplazan antes
+void tt_new_search(TransTable *tt);
+
+// 'ply' convierte los puntajes de mate entre "desde la raíz" y "desde el nodo"
+int  tt_probe(const TransTable *tt, uint64_t key, int ply, TTHit *out);
+void tt_store(TransTable *tt, uint64_t key, Move move, int score, int depth, int bound, int ply);
+
+// Permil de entradas usadas en esta búsqueda (muestra de 1000)
+int  tt_hashfull(const TransTable *tt);
+
+#endif // TT_H
@@ -0,0 +1,285 @@
+// chess-uci: motor headless con protocolo UCI (sin raylib).
+// El hilo principal lee stdin y la búsqueda corre en otro hilo, así que
+// 'stop' e 'isready' se atienden aunque haya una búsqueda en curso.
+//
+// Comandos: uci, isready, ucinewgame, setoption (Hash, Threads),
+//           position startpos|fen <fen> [moves ...], go, stop, perft N, d, quit
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "board.h"
+#include "perft.h"
+#include "search.h"
+#include "clock.h"
+
+#define HISTORY_MAX 1024
+
+/* ---------------- Estado del motor ---------------- */
+static Position   gPos;
+static uint64_t   gHistory[HISTORY_MAX];   // claves antes de gPos (repeticiones)
+static int        gHistoryLen = 0;
+static TransTable gTT;
+static int        gHashMB = 16;
+static int        gThreads = 1;
+
+// Búsqueda en curso
+static pthread_t  gSearchThread;
+static int        gSearching = 0;          // sólo lo toca el hilo principal
+static int        gStop = 0;               // lo lee la búsqueda
+static int        gInfinite = 0;           // 'go infinite': bestmove recién con stop
+static SearchLimits gLimits;
+static Position   gSearchPos;
+
+// stdout compartido entre los dos hilos: una línea por vez
+static pthread_mutex_t gOutLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void out(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    pthread_mutex_lock(&gOutLock);
+    vprintf(fmt, ap);
+    fputc('\n', stdout);
+    fflush(stdout);
+    pthread_mutex_unlock(&gOutLock);
+    va_end(ap);
+}
+
+/* ---------------- Búsqueda ---------------- */
+static void on_iteration(const SearchInfo *info, void *user) {
+    char line[64 + MAX_PLY * 6], *p = line;
+    const char *end = line + sizeof(line);
+    if (score_is_mate(info->score)) p += snprintf(p, (size_t)(end - p), "score mate %d", score_mate_in(info->score));
+    else                            p += snprintf(p, (size_t)(end - p), "score cp %d", info->score);
+    p += snprintf(p, (size_t)(end - p), " nodes %llu nps %llu hashfull %d time %d pv",
+                  (unsigned long long)info->nodes, (unsigned long long)info->nps,
+                  info->hashfull, (int)(info->seconds * 1000.0));
+    for (int i = 0; i < info->pvLength && end - p > 7; ++i) {
+        char uci[6]; move_to_uci(info->pv[i], uci);
+        p += snprintf(p, (size_t)(end - p), " %s", uci);
+    }
+    out("info depth %d seldepth %d %s", info->depth, info->seldepth, line);
+}
+
+static void *search_thread(void *arg) {
+    SearchInfo info;
+    Move best = search_best_move(&gSearchPos, &gLimits, &info);
+    // con 'go infinite' el protocolo pide esperar al stop antes del bestmove
+    while (gInfinite && !__atomic_load_n(&gStop, __ATOMIC_ACQUIRE)) {
+        struct timespec ts = { 0, 1000000 };
+        nanosleep(&ts, NULL);
+    }
+    if (best == MOVE_NONE) { out("bestmove 0000"); return NULL; }
+    char uci[6]; move_to_uci(best, uci);
+    out("bestmove %s", uci);
+    return NULL;
+}
+
+static void stop_search(void) {
+    if (!gSearching) return;
+    __atomic_store_n(&gStop, 1, __ATOMIC_RELEASE);
+    pthread_join(gSearchThread, NULL);
+    gSearching = 0;
+}
+
+/* ---------------- Comandos ---------------- */
+// Siguiente palabra de *s (separadas por espacios); NULL si no hay más
+static char *next_token(char **s) {
+    char *p = *s;
+    while (*p == ' ' || *p == '\t') p++;
+    if (!*p) return NULL;
+    char *start = p;
+    while (*p && *p != ' ' && *p != '\t') p++;
+    if (*p) *p++ = '\0';
+    *s = p;
+    return start;
+}
+
+static Move parse_uci_move(const Position *pos, const char *text) {
+    MoveList list;
+    gen_legal_moves(pos, &list);
+    for (int i = 0; i < list.count; ++i) {
+        char uci[6]; move_to_uci(list.moves[i], uci);
+        if (!strcmp(uci, text)) return list.moves[i];
+    }
+    return MOVE_NONE;
+}
+
+// Agrega la clave de la posición previa a una jugada. Si se llena, se
+// descartan las más viejas: la búsqueda necesita las que terminan en gPos.
+static void history_push(uint64_t key) {
+    if (gHistoryLen == HISTORY_MAX) {
+        memmove(gHistory, gHistory + 1, sizeof(gHistory[0]) * (HISTORY_MAX - 1));
+        gHistoryLen--;
+    }
+    gHistory[gHistoryLen++] = key;
+}
+
+// position startpos|fen <6 campos> [moves m1 m2 ...]
+static void cmd_position(char *args) {
+    char *tok = next_token(&args);
+    if (!tok) return;
+    Position pos;
+    if (!strcmp(tok, "startpos")) {
+        board_init_startpos(&pos);
+        tok = next_token(&args);
+    } else if (!strcmp(tok, "fen")) {
+        // los campos del FEN llegan como palabras sueltas, hasta "moves"
+        char fen[FEN_MAX * 2] = "";
+        size_t len = 0;
+        while ((tok = next_token(&args)) && strcmp(tok, "moves"))
+            if (len < sizeof(fen)) len += (size_t)snprintf(fen + len, sizeof(fen) - len, "%s%s", len ? " " : "", tok);
+        if (!position_from_fen(&pos, fen)) { out("info string FEN inválido: %s", fen); return; }
+    } else {
+        return;
+    }
+
+    gPos = pos;
+    gHistoryLen = 0;
+    if (tok && !strcmp(tok, "moves")) {
+        while ((tok = next_token(&args))) {
+            Move m = parse_uci_move(&gPos, tok);
+            if (m == MOVE_NONE) { out("info string jugada ilegal: %s", tok); break; }
+            history_push(gPos.key);
+            move_make(&gPos, m, NULL);
+            // antes de una captura o jugada de peón no puede haber repeticiones
+            if (gPos.halfmove == 0) gHistoryLen = 0;
+        }
+    }
+}
+
+// Tiempo para esta jugada a partir del reloj (ms); 0 = sin límite
+static int time_for_move(int timeLeft, int inc, int movesToGo) {
+    if (timeLeft <= 0) return 0;
+    int moves = movesToGo > 0 ? movesToGo : 30;
+    int t = timeLeft / moves + inc * 3 / 4;
+    int cap = timeLeft / 2;                 // nunca más de la mitad de lo que queda
+    if (t > cap) t = cap;
+    t -= 20;                                // margen para comunicación
+    return t > 1 ? t : 1;
+}
+
+static void cmd_go(char *args) {
+    stop_search();
+    memset(&gLimits, 0, sizeof(gLimits));
+    int wtime = 0, btime = 0, winc = 0, binc = 0, movesToGo = 0, moveTime = 0;
+    gInfinite = 0;
+
+    char *tok;
+    while ((tok = next_token(&args))) {
+        char *val = NULL;
+        if (strcmp(tok, "infinite") && strcmp(tok, "ponder")) val = next_token(&args);
+        if      (!strcmp(tok, "infinite"))  gInfinite = 1;
+        else if (!val)                      break;
+        else if (!strcmp(tok, "depth"))     gLimits.maxDepth = atoi(val);
+        else if (!strcmp(tok, "nodes"))     gLimits.maxNodes = strtoull(val, NULL, 10);
+        else if (!strcmp(tok, "movetime"))  moveTime = atoi(val);
+        else if (!strcmp(tok, "wtime"))     wtime = atoi(val);
+        else if (!strcmp(tok, "btime"))     btime = atoi(val);
+        else if (!strcmp(tok, "winc"))      winc = atoi(val);
+        else if (!strcmp(tok, "binc"))      binc = atoi(val);
+        else if (!strcmp(tok, "movestogo")) movesToGo = atoi(val);
+        else if (!strcmp(tok, "perft"))     { perft_divide_parallel(&gPos, atoi(val), gThreads, NULL); fflush(stdout); return; }
+    }
+
+    if (moveTime > 0) gLimits.maxTimeMs = moveTime;
+    else if (!gInfinite) {
+        gLimits.maxTimeMs = gPos.side == 1 ? time_for_move(wtime, winc, movesToGo)
+                                           : time_for_move(btime, binc, movesToGo);
+    }
+
+    gSearchPos = gPos;
+    gLimits.stop = &gStop;
+    gLimits.history = gHistory;
+    gLimits.historyLen = gHistoryLen;
+    gLimits.tt = &gTT;
+    gLimits.threads = gThreads;
+    gLimits.onIteration = on_iteration;
+    __atomic_store_n(&gStop, 0, __ATOMIC_RELEASE);
+    if (pthread_create(&gSearchThread, NULL, search_thread, NULL) != 0) {
+        out("bestmove 0000");
+        return;
+    }
+    gSearching = 1;
+}
+
+// setoption name <Nombre> value <valor>
+static void cmd_setoption(char *args) {
+    char *tok = next_token(&args), *name = NULL, *value = NULL;
+    if (!tok || strcmp(tok, "name")) return;
+    name = next_token(&args);
+    if ((tok = next_token(&args)) && !strcmp(tok, "value")) value = next_token(&args);
+    if (!name || !value) return;
+
+    if (!strcmp(name, "Hash")) {
+        int mb = atoi(value);
+        if (mb < 1) mb = 1;
+        if (mb > 65536) mb = 65536;
+        stop_search();
+        tt_free(&gTT);
+        if (tt_init(&gTT, (size_t)mb, 0)) {
+            gHashMB = mb;
+        } else if (tt_init(&gTT, (size_t)gHashMB, 0)) {
+            // se vuelve al tamaño anterior: gHashMB sigue diciendo el real
+            out("info string Hash: no hay memoria para %d MB, se usan %d MB", mb, gHashMB);
+        } else {
+            out("info string sin memoria para la TT");
+            exit(1);
+        }
+    } else if (!strcmp(name, "Threads")) {
+        int n = atoi(value);
+        gThreads = n < 1 ? 1 : n > 256 ? 256 : n;
+    }
+}
+
+static int handle_line(char *line) {
+    char *args = line;
+    char *cmd = next_token(&args);
+    if (!cmd) return 1;
+
+    if (!strcmp(cmd, "uci")) {
+        out("id name chess-c");
+        out("id author Fedebarriosd");
+        out("option name Hash type spin default 16 min 1 max 65536");
+        out("option name Threads type spin default 1 min 1 max 256");
+        out("uciok");
+    }
+    else if (!strcmp(cmd, "isready"))    out("readyok");
+    else if (!strcmp(cmd, "ucinewgame")) { stop_search(); tt_clear(&gTT); }
+    else if (!strcmp(cmd, "setoption"))  cmd_setoption(args);
+    else if (!strcmp(cmd, "position"))   { stop_search(); cmd_position(args); }
+    else if (!strcmp(cmd, "go"))         cmd_go(args);
+    else if (!strcmp(cmd, "stop"))       stop_search();
+    else if (!strcmp(cmd, "perft")) {
+        char *depth = next_token(&args);
+        stop_search();
+        perft_divide_parallel(&gPos, depth ? atoi(depth) : 1, gThreads, NULL);
+        fflush(stdout);
+    }
+    else if (!strcmp(cmd, "d")) {
+        char fen[FEN_MAX];
+        position_to_fen(&gPos, fen);
+        out("Fen: %s", fen);
+        out("Key: %016llx", (unsigned long long)gPos.key);
+    }
+    else if (!strcmp(cmd, "quit"))       { stop_search(); return 0; }
+    else if (!strcmp(cmd, "ponderhit"))  { /* sin ponder: nada */ }
+    else out("info string comando desconocido: %s", cmd);
+    return 1;
+}
+
+int main(void) {
+    board_init_startpos(&gPos);
+    if (!tt_init(&gTT, (size_t)gHashMB, 0)) { fprintf(stderr, "Sin memoria para la TT\n"); return 1; }
+
+    char line[8192];
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!handle_line(line)) break;
+    }
+    stop_search();
+    tt_free(&gTT);
+    return 0;
+}
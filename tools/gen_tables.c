@@ -0,0 +1,258 @@
+// gen_tables: genera en compilación las tablas de ataques y el Zobrist.
+// CMake lo compila y lo corre antes de chesscore; board.c incluye la salida,
+// así las tablas son 'static const' (páginas de sólo lectura compartidas
+// entre procesos) y no hay nada que inicializar al arrancar.
+//
+// Uso: gen_tables <salida.inc>
+//
+// Las sub-tablas de alfil/torre se emiten en los dos órdenes posibles (magic
+// y PEXT) bajo #ifdef USE_PEXT; el índice PEXT se calcula por software, así
+// que el generador no necesita una CPU con BMI2.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const uint64_t NOT_FILE_A = 0xfefefefefefefefeULL;
+static const uint64_t NOT_FILE_B = 0xfdfdfdfdfdfdfdfdULL;
+static const uint64_t NOT_FILE_G = 0xbfbfbfbfbfbfbfbfULL;
+static const uint64_t NOT_FILE_H = 0x7f7f7f7f7f7f7f7fULL;
+static const uint64_t FILE_A     = 0x0101010101010101ULL;
+static const uint64_t FILE_H     = 0x8080808080808080ULL;
+
+static uint64_t bit_at(int sq) { return 1ULL << sq; }
+
+/* ---------------- Ataques: Alfiles (raycast en 4 diagonales) ---------------- */
+static uint64_t bishop_attacks_on_the_fly(int sq, uint64_t occ) {
+    uint64_t attacks = 0ULL;
+    int f = sq % 8, r = sq / 8;
+
+    for (int ff=f+1, rr=r+1; ff<8 && rr<8; ++ff, ++rr) { int s=rr*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
+    for (int ff=f-1, rr=r+1; ff>=0 && rr<8; --ff, ++rr) { int s=rr*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
+    for (int ff=f+1, rr=r-1; ff<8 && rr>=0; ++ff, --rr) { int s=rr*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
+    for (int ff=f-1, rr=r-1; ff>=0 && rr>=0; --ff, --rr) { int s=rr*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
+    return attacks;
+}
+
+/* ---------------- Ataques: Torres (raycast ortogonal) ---------------- */
+static uint64_t rook_attacks_on_the_fly(int sq, uint64_t occ) {
+    uint64_t attacks = 0ULL;
+    int f = sq % 8, r = sq / 8;
+
+    for (int rr=r+1; rr<8; ++rr) { int s=rr*8+f; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
+    for (int rr=r-1; rr>=0; --rr){ int s=rr*8+f; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
+    for (int ff=f+1; ff<8; ++ff) { int s=r*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
+    for (int ff=f-1; ff>=0; --ff){ int s=r*8+ff; uint64_t bm=bit_at(s); attacks|=bm; if (occ&bm) break; }
+    return attacks;
+}
+
+/* ---------------- Magic bitboards / PEXT ---------------- */
+// Multiplicadores encontrados offline por búsqueda aleatoria (shift fijo por
+// casilla). Con PEXT no hacen falta.
+static const uint64_t BISHOP_MAGIC_NUMBERS[64] = {
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL, 0x5204042080000088ULL,
+    0x2204106880000002ULL, 0x1401042004000000ULL, 0x0400880410042004ULL, 0x0028208200A02020ULL,
+    0x1500241990010E00ULL, 0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL, 0x8000088400880520ULL,
+    0x0405004010040100ULL, 0x1005823210040108ULL, 0x2708008102040011ULL, 0x4048200404009100ULL,
+    0x0018104101400024ULL, 0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL, 0x0894080000220040ULL,
+    0x1001010083104000ULL, 0x5004030040900080ULL, 0x000400422C012400ULL, 0x0002128698404812ULL,
+    0x1010108404900440ULL, 0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL, 0x802A02020000B098ULL,
+    0x0009015090004060ULL, 0x4000821082081001ULL, 0x0100210040420800ULL, 0x0800004010488A00ULL,
+    0x2000081104004040ULL, 0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL, 0x3040290220884800ULL,
+    0x4A1500401041004AULL, 0x8010200282020781ULL, 0x0020203142209091ULL, 0x0070300600902110ULL,
+    0x0040808800B62048ULL, 0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL, 0x4040702400932244ULL,
+};
+static const uint64_t ROOK_MAGIC_NUMBERS[64] = {
+    0x1080008040001021ULL, 0x0100210040001080ULL, 0x4100100820004100ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL,
+};
+
+#define BISHOP_TABLE_SIZE 5248      // suma de 2^bits de las 64 casillas
+#define ROOK_TABLE_SIZE   102400
+
+// Máscara relevante: el rayo sobre tablero vacío sin la casilla del borde
+static uint64_t slider_mask(int sq, int isRook) {
+    int f = sq % 8, r = sq / 8;
+    uint64_t edges = ((0x00000000000000FFULL | 0xFF00000000000000ULL) & ~(0xFFULL << (8*r))) |
+                     ((FILE_A | FILE_H) & ~(FILE_A << f));
+    uint64_t rays = isRook ? rook_attacks_on_the_fly(sq, 0ULL) : bishop_attacks_on_the_fly(sq, 0ULL);
+    return rays & ~edges;
+}
+
+// _pext_u64 por software: los bits de x bajo 'mask', compactados abajo
+static uint64_t pext_soft(uint64_t x, uint64_t mask) {
+    uint64_t r = 0ULL;
+    for (int k = 0; mask; ++k, mask &= mask - 1)
+        if (x & mask & (0 - mask)) r |= 1ULL << k;
+    return r;
+}
+
+typedef struct {
+    uint64_t mask[64];
+    int      shift[64];
+    int      offset[64];    // inicio de la sub-tabla de cada casilla
+    uint64_t magicTable[ROOK_TABLE_SIZE];
+    uint64_t pextTable[ROOK_TABLE_SIZE];
+    int      size;
+} SliderTables;
+
+static int build_slider(SliderTables *t, const uint64_t *magics, int isRook, int capacity) {
+    static unsigned char used[ROOK_TABLE_SIZE];
+    int next = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        uint64_t mask = slider_mask(sq, isRook);
+        int bits = __builtin_popcountll(mask);
+        t->mask[sq] = mask;
+        t->shift[sq] = 64 - bits;
+        t->offset[sq] = next;
+        if (next + (1 << bits) > capacity) return 0;
+        for (int i = 0; i < (1 << bits); ++i) used[next + i] = 0;
+
+        // Recorrer todos los subconjuntos de la máscara (Carry-Rippler)
+        uint64_t sub = 0ULL;
+        do {
+            uint64_t atk = isRook ? rook_attacks_on_the_fly(sq, sub) : bishop_attacks_on_the_fly(sq, sub);
+            int mi = next + (int)((sub * magics[sq]) >> t->shift[sq]);
+            // un magic válido sólo puede chocar entre ocupaciones con el mismo ataque
+            if (used[mi] && t->magicTable[mi] != atk) {
+                fprintf(stderr, "gen_tables: magic inválido en la casilla %d\n", sq);
+                return 0;
+            }
+            used[mi] = 1;
+            t->magicTable[mi] = atk;
+            t->pextTable[next + (int)pext_soft(sub, mask)] = atk;
+            sub = (sub - mask) & mask;
+        } while (sub);
+        next += 1 << bits;
+    }
+    t->size = next;
+    return next == capacity;
+}
+
+/* ---------------- Salida ---------------- */
+// 'cols' > 0: matriz de filas de 'cols' elementos (llaves anidadas)
+static void emit_array(FILE *out, const char *decl, const uint64_t *v, int n, int cols) {
+    fprintf(out, "static const uint64_t %s = {\n", decl);
+    if (!cols) cols = n;
+    for (int row = 0; row < n; row += cols) {
+        if (cols < n) fputs("  {\n", out);
+        for (int i = 0; i < cols; ++i)
+            fprintf(out, "%s0x%016llxULL,%s", i % 4 ? " " : "    ",
+                    (unsigned long long)v[row + i], i % 4 == 3 || i == cols - 1 ? "\n" : "");
+        if (cols < n) fputs("  },\n", out);
+    }
+    fputs("};\n", out);
+}
+
+static void emit_magics(FILE *out, const char *name, const char *table, const SliderTables *t, const uint64_t *magics) {
+    fprintf(out, "static const Magic %s[64] = {\n", name);
+    for (int sq = 0; sq < 64; ++sq)
+        fprintf(out, "    { 0x%016llxULL, 0x%016llxULL, %s + %d, %d },\n",
+                (unsigned long long)t->mask[sq], (unsigned long long)magics[sq], table, t->offset[sq], t->shift[sq]);
+    fputs("};\n", out);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) { fprintf(stderr, "Uso: %s <salida.inc>\n", argv[0]); return 2; }
+
+    // Caballo, rey y peones
+    uint64_t knight[64], king[64], pawn[2][64];
+    for (int sq = 0; sq < 64; ++sq) {
+        uint64_t m = bit_at(sq);
+        knight[sq] = ((m & NOT_FILE_H) << 17) | ((m & NOT_FILE_A) << 15) |
+                     ((m & NOT_FILE_H) >> 15) | ((m & NOT_FILE_A) >> 17) |
+                     ((m & NOT_FILE_G & NOT_FILE_H) << 10) | ((m & NOT_FILE_G & NOT_FILE_H) >> 6) |
+                     ((m & NOT_FILE_A & NOT_FILE_B) << 6)  | ((m & NOT_FILE_A & NOT_FILE_B) >> 10);
+        king[sq] = ((m & NOT_FILE_H) << 1) | ((m & NOT_FILE_A) >> 1) | (m << 8) | (m >> 8) |
+                   ((m & NOT_FILE_H) << 9) | ((m & NOT_FILE_A) << 7) |
+                   ((m & NOT_FILE_H) >> 7) | ((m & NOT_FILE_A) >> 9);
+        pawn[0][sq] = ((m & NOT_FILE_H) >> 7) | ((m & NOT_FILE_A) >> 9);   // negras
+        pawn[1][sq] = ((m & NOT_FILE_A) << 7) | ((m & NOT_FILE_H) << 9);   // blancas
+    }
+
+    // Alfiles y torres
+    static SliderTables bishops, rooks;
+    if (!build_slider(&bishops, BISHOP_MAGIC_NUMBERS, 0, BISHOP_TABLE_SIZE) ||
+        !build_slider(&rooks, ROOK_MAGIC_NUMBERS, 1, ROOK_TABLE_SIZE)) {
+        fprintf(stderr, "gen_tables: tamaño de tabla deslizante inesperado\n");
+        return 1;
+    }
+
+    // BETWEEN[a][b]: casillas estrictamente entre a y b si están alineadas.
+    // LINE[a][b]:    la línea completa (borde a borde) que pasa por a y b.
+    static uint64_t between[64][64], line[64][64];
+    for (int a = 0; a < 64; ++a) {
+        for (int b = 0; b < 64; ++b) {
+            if (a == b) continue;
+            uint64_t ab = bit_at(a) | bit_at(b);
+            if (rook_attacks_on_the_fly(a, 0ULL) & bit_at(b)) {
+                between[a][b] = rook_attacks_on_the_fly(a, bit_at(b)) & rook_attacks_on_the_fly(b, bit_at(a));
+                line[a][b]    = (rook_attacks_on_the_fly(a, 0ULL) & rook_attacks_on_the_fly(b, 0ULL)) | ab;
+            } else if (bishop_attacks_on_the_fly(a, 0ULL) & bit_at(b)) {
+                between[a][b] = bishop_attacks_on_the_fly(a, bit_at(b)) & bishop_attacks_on_the_fly(b, bit_at(a));
+                line[a][b]    = (bishop_attacks_on_the_fly(a, 0ULL) & bishop_attacks_on_the_fly(b, 0ULL)) | ab;
+            }
+        }
+    }
+
+    // Zobrist: xorshift64* con semilla fija, mismas claves en cada compilación
+    uint64_t zPiece[12 * 64], zCastle[16], zEp[8], zSide, x = 0x9E3779B97F4A7C15ULL;
+    #define NEXT_RAND() (x ^= x >> 12, x ^= x << 25, x ^= x >> 27, x * 0x2545F4914F6CDD1DULL)
+    for (int i = 0; i < 12 * 64; ++i) zPiece[i] = NEXT_RAND();
+    for (int i = 0; i < 16; ++i)      zCastle[i] = NEXT_RAND();
+    for (int i = 0; i < 8; ++i)       zEp[i] = NEXT_RAND();
+    zSide = NEXT_RAND();
+    #undef NEXT_RAND
+
+    FILE *out = fopen(argv[1], "w");
+    if (!out) { perror(argv[1]); return 1; }
+    fputs("// Generado por tools/gen_tables.c durante la compilación: no editar.\n"
+          "// Lo incluye board.c (después de definir Magic y USE_PEXT).\n\n", out);
+
+    emit_array(out, "KNIGHT_ATTACKS[64]", knight, 64, 0);
+    emit_array(out, "KING_ATTACKS[64]", king, 64, 0);
+    fputs("// [0] negras, [1] blancas\n", out);
+    emit_array(out, "PAWN_ATTACKS[2][64]", pawn[0], 128, 64);
+
+    fputs("\n// Sub-tablas deslizantes: mismo tamaño por casilla en los dos órdenes\n#ifdef USE_PEXT\n", out);
+    emit_array(out, "BISHOP_TABLE[5248]", bishops.pextTable, BISHOP_TABLE_SIZE, 0);
+    emit_array(out, "ROOK_TABLE[102400]", rooks.pextTable, ROOK_TABLE_SIZE, 0);
+    fputs("#else\n", out);
+    emit_array(out, "BISHOP_TABLE[5248]", bishops.magicTable, BISHOP_TABLE_SIZE, 0);
+    emit_array(out, "ROOK_TABLE[102400]", rooks.magicTable, ROOK_TABLE_SIZE, 0);
+    fputs("#endif\n", out);
+    emit_magics(out, "BISHOP_MAGICS", "BISHOP_TABLE", &bishops, BISHOP_MAGIC_NUMBERS);
+    emit_magics(out, "ROOK_MAGICS", "ROOK_TABLE", &rooks, ROOK_MAGIC_NUMBERS);
+
+    fputs("\n", out);
+    emit_array(out, "BETWEEN[64][64]", between[0], 64 * 64, 64);
+    emit_array(out, "LINE[64][64]", line[0], 64 * 64, 64);
+
+    fputs("\n// Zobrist (EP por columna)\n", out);
+    emit_array(out, "ZOBRIST_PIECE[12][64]", zPiece, 12 * 64, 64);
+    emit_array(out, "ZOBRIST_CASTLE[16]", zCastle, 16, 0);
+    emit_array(out, "ZOBRIST_EP[8]", zEp, 8, 0);
+    fprintf(out, "static const uint64_t ZOBRIST_SIDE = 0x%016llxULL;  // cuando mueven negras\n",
+            (unsigned long long)zSide);
+
+    if (fclose(out) != 0) { perror(argv[1]); return 1; }
+    return 0;
+}